@@ -0,0 +1,164 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_ATTENTION_H
+#define MATRIX_ATTENTION_H
+
+#include "matrix.h"
+
+#include <limits>
+
+namespace matrix {
+    struct attention_options {
+        bool causal = false;
+        double scale = 0;
+    };
+
+    // Numerically stable softmax of every row.
+    template<typename A>
+    auto softmax(const A& operand) {
+        auto x = __as_view(operand);
+        using T = typename decltype(x)::value_type;
+        matrix<T> result(x);
+
+        for (size_t row = 0; row < result.rows(); row++) {
+            T largest = -std::numeric_limits<T>::infinity();
+            T sum = T();
+
+            for (size_t column = 0; column < result.columns(); column++) {
+                largest = std::max(largest, result(row, column));
+            }
+
+            for (size_t column = 0; column < result.columns(); column++) {
+                result(row, column) = std::exp(result(row, column) - largest);
+                sum = sum + result(row, column);
+            }
+
+            for (size_t column = 0; column < result.columns(); column++) {
+                result(row, column) = result(row, column) / sum;
+            }
+        }
+
+        return result;
+    }
+
+    // softmax(scale Q K^T) V without forming the score matrix. Queries are
+    // processed in blocks against key/value tiles; each score tile comes from
+    // gemm and is folded into a running row maximum, row sum and output
+    // accumulator (online softmax), so working memory is one tile per query
+    // block. The default scale is 1 / sqrt(d). With options.causal, query i
+    // sees keys j <= i + (keys - queries), which is the usual mask when the
+    // queries are the last rows of the key sequence.
+    template<typename Q, typename K, typename V>
+    auto attention(const Q& queries, const K& keys, const V& values, const attention_options& options = attention_options()) {
+        auto q = __as_view(queries);
+        auto k = __as_view(keys);
+        auto v = __as_view(values);
+        using T = typename decltype(q)::value_type;
+        constexpr size_t query_block = 64;
+        constexpr size_t key_block = 256;
+#ifndef MATRIX_NOTHROW
+        if ((q.columns() != k.columns()) || (k.rows() != v.rows())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t n = q.rows();
+        size_t m = k.rows();
+        size_t d = v.columns();
+        T scale = (options.scale != 0) ? T(options.scale) : T(1) / std::sqrt(T(q.columns()));
+        long offset = static_cast<long>(m) - static_cast<long>(n);
+        matrix<T> result(n, d);
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t q0 = 0; q0 < n; q0 += query_block) {
+            size_t rows = std::min(query_block, n - q0);
+            matrix<T> scores(rows, std::min(key_block, m));
+            std::vector<T> largest(rows, -std::numeric_limits<T>::infinity());
+            std::vector<T> sum(rows);
+            matrix_view<T> output = result.block(q0, 0, rows, d);
+            size_t end = m;
+
+            if (options.causal) {
+                end = static_cast<size_t>(std::clamp<long>(static_cast<long>(q0 + rows) + offset, 0, static_cast<long>(m)));
+            }
+
+            for (size_t k0 = 0; k0 < end; k0 += key_block) {
+                size_t columns = std::min(key_block, end - k0);
+                matrix_view<T> tile = scores.block(0, 0, rows, columns);
+                gemm(scale, q.block(q0, 0, rows, q.columns()), k.block(k0, 0, columns, k.columns()).t(), T(), tile);
+
+                for (size_t i = 0; i < rows; i++) {
+                    size_t visible = columns;
+
+                    if (options.causal) {
+                        long last = static_cast<long>(q0 + i) + offset - static_cast<long>(k0);
+                        visible = static_cast<size_t>(std::clamp<long>(last + 1, 0, static_cast<long>(columns)));
+                    }
+
+                    T next = largest[i];
+
+                    for (size_t j = 0; j < visible; j++) {
+                        next = std::max(next, tile(i, j));
+                    }
+
+                    if (visible == 0) {
+                        for (size_t j = 0; j < columns; j++) {
+                            tile(i, j) = T();
+                        }
+
+                        continue;
+                    }
+
+                    T correction = std::exp(largest[i] - next);
+                    T total = T();
+
+                    for (size_t j = 0; j < columns; j++) {
+                        tile(i, j) = (j < visible) ? std::exp(tile(i, j) - next) : T();
+                        total = total + tile(i, j);
+                    }
+
+                    for (size_t j = 0; j < d; j++) {
+                        output(i, j) = output(i, j) * correction;
+                    }
+
+                    largest[i] = next;
+                    sum[i] = sum[i] * correction + total;
+                }
+
+                gemm(T(1), tile, v.block(k0, 0, columns, d), T(1), output);
+            }
+
+            for (size_t i = 0; i < rows; i++) {
+                for (size_t j = 0; j < d; j++) {
+                    output(i, j) = (sum[i] > T()) ? output(i, j) / sum[i] : T();
+                }
+            }
+        }
+
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,592 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_BIT_MATRIX_H
+#define MATRIX_BIT_MATRIX_H
+
+#include "matrix.h"
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+#include <immintrin.h>
+#endif
+
+namespace matrix {
+    inline unsigned __lowest_bit(uint64_t value) {
+#if defined(__GNUC__) || defined(__clang__)
+        unsigned result = static_cast<unsigned>(__builtin_ctzll(value));
+#else
+        unsigned result = 0;
+
+        while (((value >> result) & 1) == 0) {
+            result++;
+        }
+#endif
+        return result;
+    }
+
+    // x86 builds without POPCNT would turn the builtin into a library call,
+    // which is slower than the inline SWAR count.
+    inline unsigned __popcount(uint64_t value) {
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__POPCNT__) || !(defined(__x86_64__) || defined(__i386__)))
+        unsigned result = static_cast<unsigned>(__builtin_popcountll(value));
+#else
+        value = value - ((value >> 1) & 0x5555555555555555);
+        value = (value & 0x3333333333333333) + ((value >> 2) & 0x3333333333333333);
+        value = (value + (value >> 4)) & 0x0f0f0f0f0f0f0f0f;
+        unsigned result = static_cast<unsigned>((value * 0x0101010101010101) >> 56);
+#endif
+        return result;
+    }
+
+    // Matrix over GF(2) with each row packed into 64-bit words, column c in
+    // bit c % 64 of word c / 64. Addition is XOR and row operations run a
+    // word at a time; padding bits past the last column are kept zero.
+    class bit_matrix {
+    private:
+        size_t m_rows;
+        size_t m_columns;
+        size_t m_words;
+        std::vector<uint64_t> m_data;
+
+    public:
+        bit_matrix() : m_rows(0), m_columns(0), m_words(0) {}
+
+        bit_matrix(size_t rows, size_t columns) : m_rows(rows), m_columns(columns), m_words((columns + 63) / 64), m_data(rows * ((columns + 63) / 64)) {}
+
+        // Nonzero elements become ones.
+        template<typename T, size_t Rows, size_t Columns>
+        explicit bit_matrix(const matrix<T, Rows, Columns>& operand) : bit_matrix(operand.rows(), operand.columns()) {
+            for (size_t row = 0; row < m_rows; row++) {
+                for (size_t column = 0; column < m_columns; column++) {
+                    set(row, column, operand(row, column) != T());
+                }
+            }
+        }
+
+        static bit_matrix identity(size_t size) {
+            bit_matrix result(size, size);
+
+            for (size_t index = 0; index < size; index++) {
+                result.set(index, index, true);
+            }
+
+            return result;
+        }
+
+        size_t rows() const {
+            size_t result = m_rows;
+            return result;
+        }
+
+        size_t columns() const {
+            size_t result = m_columns;
+            return result;
+        }
+
+        size_t words() const {
+            size_t result = m_words;
+            return result;
+        }
+
+        uint64_t* row(size_t index) {
+            uint64_t* result = m_data.data() + index * m_words;
+            return result;
+        }
+
+        const uint64_t* row(size_t index) const {
+            const uint64_t* result = m_data.data() + index * m_words;
+            return result;
+        }
+
+        bool operator()(size_t row, size_t column) const {
+#ifndef MATRIX_NOTHROW
+            if (row >= m_rows) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+
+            if (column >= m_columns) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+#endif
+            bool result = (m_data[row * m_words + column / 64] >> (column % 64)) & 1;
+            return result;
+        }
+
+        void set(size_t row, size_t column, bool value) {
+#ifndef MATRIX_NOTHROW
+            if (row >= m_rows) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+
+            if (column >= m_columns) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+#endif
+            uint64_t mask = uint64_t(1) << (column % 64);
+            uint64_t& word = m_data[row * m_words + column / 64];
+            word = value ? (word | mask) : (word & ~mask);
+        }
+
+        void swap_rows(size_t first, size_t second) {
+            if (first != second) {
+                std::swap_ranges(row(first), row(first) + m_words, row(second));
+            }
+        }
+
+        // row(target) ^= row(source), from word `from` onwards.
+        void add_row(size_t target, size_t source, size_t from = 0) {
+            uint64_t* x = row(target);
+            const uint64_t* y = row(source);
+
+            for (size_t word = from; word < m_words; word++) {
+                x[word] = x[word] ^ y[word];
+            }
+        }
+
+        template<typename T = uint8_t>
+        matrix<T> to_matrix() const {
+            matrix<T> result(m_rows, m_columns);
+
+            for (size_t row = 0; row < m_rows; row++) {
+                for (size_t column = 0; column < m_columns; column++) {
+                    result(row, column) = (*this)(row, column) ? T(1) : T();
+                }
+            }
+
+            return result;
+        }
+
+        bool operator==(const bit_matrix& other) const {
+            bool result = (m_rows == other.m_rows) && (m_columns == other.m_columns) && (m_data == other.m_data);
+            return result;
+        }
+
+        bool operator!=(const bit_matrix& other) const {
+            bool result = !(*this == other);
+            return result;
+        }
+
+        bit_matrix operator+(const bit_matrix& other) const {
+#ifndef MATRIX_NOTHROW
+            if ((m_rows != other.m_rows) || (m_columns != other.m_columns)) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            bit_matrix result = *this;
+
+            for (size_t index = 0; index < m_data.size(); index++) {
+                result.m_data[index] = result.m_data[index] ^ other.m_data[index];
+            }
+
+            return result;
+        }
+
+        // Method of Four Russians: for every 8 rows of the right operand the
+        // 256 XOR combinations are tabulated once, and each row of the result
+        // then takes one table row per byte of the left operand.
+        bit_matrix operator*(const bit_matrix& other) const {
+#ifndef MATRIX_NOTHROW
+            if (m_columns != other.m_rows) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            size_t w = other.m_words;
+            bit_matrix result(m_rows, other.m_columns);
+            std::vector<uint64_t> table(256 * w);
+
+            for (size_t k0 = 0; k0 < m_columns; k0 += 8) {
+                size_t count = std::min<size_t>(8, m_columns - k0);
+
+                for (size_t index = 1; index < (size_t(1) << count); index++) {
+                    const uint64_t* previous = table.data() + (index & (index - 1)) * w;
+                    const uint64_t* source = other.row(k0 + __lowest_bit(index));
+                    uint64_t* target = table.data() + index * w;
+
+                    for (size_t word = 0; word < w; word++) {
+                        target[word] = previous[word] ^ source[word];
+                    }
+                }
+
+                for (size_t r = 0; r < m_rows; r++) {
+                    size_t index = (row(r)[k0 / 64] >> (k0 % 64)) & 0xff;
+
+                    if (index != 0) {
+                        const uint64_t* source = table.data() + index * w;
+                        uint64_t* target = result.row(r);
+
+                        for (size_t word = 0; word < w; word++) {
+                            target[word] = target[word] ^ source[word];
+                        }
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        bit_matrix transpose() const {
+            bit_matrix result(m_columns, m_rows);
+
+            for (size_t r = 0; r < m_rows; r++) {
+                const uint64_t* source = row(r);
+
+                for (size_t word = 0; word < m_words; word++) {
+                    for (uint64_t bits = source[word]; bits != 0; bits = bits & (bits - 1)) {
+                        result.set(word * 64 + __lowest_bit(bits), r, true);
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        // In-place reduced row echelon form over GF(2), pivoting only in the
+        // first `limit` columns; returns the pivot columns (their count is
+        // the rank). M4RI: pivots are found eight columns at a time, the 256
+        // combinations of those pivot rows are tabulated, and every other row
+        // is cleared in the strip with a single table XOR.
+        std::vector<size_t> echelonize(size_t limit) {
+            limit = std::min(limit, m_columns);
+            std::vector<size_t> result;
+            std::vector<uint64_t> table(256 * m_words);
+            size_t r = 0;
+
+            for (size_t c0 = 0; (c0 < limit) && (r < m_rows); c0 += 8) {
+                size_t word = c0 / 64;
+                size_t shift = c0 % 64;
+                size_t width = std::min<size_t>(8, limit - c0);
+                size_t pivots[8];
+                size_t found = 0;
+
+                auto strip = [&](size_t index) {
+                    size_t value = (row(index)[word] >> shift) & 0xff;
+                    return value;
+                };
+
+                for (size_t bit = 0; (bit < width) && (r + found < m_rows); bit++) {
+                    for (size_t candidate = r + found; candidate < m_rows; candidate++) {
+                        size_t bits = strip(candidate);
+
+                        for (size_t p = 0; p < found; p++) {
+                            if ((bits >> pivots[p]) & 1) {
+                                bits = bits ^ strip(r + p);
+                            }
+                        }
+
+                        if ((bits >> bit) & 1) {
+                            for (size_t p = 0; p < found; p++) {
+                                if ((strip(candidate) >> pivots[p]) & 1) {
+                                    add_row(candidate, r + p, word);
+                                }
+                            }
+
+                            swap_rows(candidate, r + found);
+
+                            for (size_t p = 0; p < found; p++) {
+                                if ((strip(r + p) >> bit) & 1) {
+                                    add_row(r + p, r + found, word);
+                                }
+                            }
+
+                            pivots[found] = bit;
+                            found++;
+                            break;
+                        }
+                    }
+                }
+
+                if (found == 0) {
+                    continue;
+                }
+
+                std::fill(table.begin(), table.begin() + m_words, uint64_t(0));
+                size_t pivot_row[8];
+                size_t mask = 0;
+
+                for (size_t bit = 0; bit < 8; bit++) {
+                    pivot_row[bit] = m_rows;
+                }
+
+                for (size_t p = 0; p < found; p++) {
+                    pivot_row[pivots[p]] = r + p;
+                    mask = mask | (size_t(1) << pivots[p]);
+                }
+
+                for (size_t index = 1; index < 256; index++) {
+                    const uint64_t* previous = table.data() + (index & (index - 1)) * m_words;
+                    uint64_t* target = table.data() + index * m_words;
+                    size_t source = pivot_row[__lowest_bit(index)];
+
+                    for (size_t w = word; w < m_words; w++) {
+                        target[w] = (source < m_rows) ? previous[w] ^ row(source)[w] : previous[w];
+                    }
+                }
+
+                for (size_t index = 0; index < m_rows; index++) {
+                    if ((index >= r) && (index < r + found)) {
+                        continue;
+                    }
+
+                    size_t bits = strip(index) & mask;
+
+                    if (bits != 0) {
+                        const uint64_t* source = table.data() + bits * m_words;
+                        uint64_t* target = row(index);
+
+                        for (size_t w = word; w < m_words; w++) {
+                            target[w] = target[w] ^ source[w];
+                        }
+                    }
+                }
+
+                for (size_t p = 0; p < found; p++) {
+                    result.push_back(c0 + pivots[p]);
+                }
+
+                r = r + found;
+            }
+
+            return result;
+        }
+
+        size_t rank() const {
+            bit_matrix copy = *this;
+            size_t result = copy.echelonize(m_columns).size();
+            return result;
+        }
+
+        bool determinant() const {
+#ifndef MATRIX_NOTHROW
+            if (m_rows != m_columns) {
+                throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+            }
+#endif
+            bool result = rank() == m_rows;
+            return result;
+        }
+    };
+
+    // A particular solution of A X = B over GF(2), free variables set to
+    // zero, from the echelon form of [A | B].
+    inline bit_matrix solve(const bit_matrix& a, const bit_matrix& b) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != b.rows()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t n = a.columns();
+        bit_matrix augmented(a.rows(), n + b.columns());
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            std::copy(a.row(row), a.row(row) + a.words(), augmented.row(row));
+
+            for (size_t column = 0; column < b.columns(); column++) {
+                if (b(row, column)) {
+                    augmented.set(row, n + column, true);
+                }
+            }
+        }
+
+        std::vector<size_t> pivots = augmented.echelonize(n);
+        bit_matrix result(n, b.columns());
+
+        for (size_t row = pivots.size(); row < a.rows(); row++) {
+            for (size_t column = 0; column < b.columns(); column++) {
+#ifndef MATRIX_NOTHROW
+                if (augmented(row, n + column)) {
+                    throw std::runtime_error(__error_messages[ERR_SINGULAR]);
+                }
+#endif
+            }
+        }
+
+        for (size_t index = 0; index < pivots.size(); index++) {
+            for (size_t column = 0; column < b.columns(); column++) {
+                result.set(pivots[index], column, augmented(index, n + column));
+            }
+        }
+
+        return result;
+    }
+
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+    inline uint64_t __sum_lanes(__m512i value) {
+        uint64_t lanes[8];
+        _mm512_storeu_si512(lanes, value);
+        uint64_t result = 0;
+
+        for (size_t lane = 0; lane < 8; lane++) {
+            result = result + lanes[lane];
+        }
+
+        return result;
+    }
+#endif
+
+    struct __bit_and {
+        uint64_t operator()(uint64_t x, uint64_t y) const {
+            uint64_t result = x & y;
+            return result;
+        }
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+        __m512i operator()(__m512i x, __m512i y) const {
+            __m512i result = _mm512_and_si512(x, y);
+            return result;
+        }
+#endif
+    };
+
+    struct __bit_xor {
+        uint64_t operator()(uint64_t x, uint64_t y) const {
+            uint64_t result = x ^ y;
+            return result;
+        }
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+        __m512i operator()(__m512i x, __m512i y) const {
+            __m512i result = _mm512_xor_si512(x, y);
+            return result;
+        }
+#endif
+    };
+
+    // popcount(op(x, y_k)) for one packed row x against up to four rows y_k
+    // that are `stride` words apart; missing rows repeat the last one. With
+    // AVX-512 VPOPCNTDQ eight words are counted per instruction into 64-bit
+    // lanes, reduced once at the end.
+    template<typename Op>
+    void __popcount_kernel(const uint64_t* x, const uint64_t* y, size_t count, size_t stride, size_t words, Op op, uint64_t* counts) {
+        const uint64_t* y0 = y;
+        const uint64_t* y1 = y + std::min<size_t>(1, count - 1) * stride;
+        const uint64_t* y2 = y + std::min<size_t>(2, count - 1) * stride;
+        const uint64_t* y3 = y + std::min<size_t>(3, count - 1) * stride;
+        uint64_t c0 = 0, c1 = 0, c2 = 0, c3 = 0;
+        size_t word = 0;
+#if defined(__AVX512F__) && defined(__AVX512VPOPCNTDQ__)
+        __m512i s0 = _mm512_setzero_si512(), s1 = _mm512_setzero_si512(), s2 = _mm512_setzero_si512(), s3 = _mm512_setzero_si512();
+
+        for (; word + 8 <= words; word += 8) {
+            __m512i u = _mm512_loadu_si512(x + word);
+            s0 = _mm512_add_epi64(s0, _mm512_popcnt_epi64(op(u, _mm512_loadu_si512(y0 + word))));
+            s1 = _mm512_add_epi64(s1, _mm512_popcnt_epi64(op(u, _mm512_loadu_si512(y1 + word))));
+            s2 = _mm512_add_epi64(s2, _mm512_popcnt_epi64(op(u, _mm512_loadu_si512(y2 + word))));
+            s3 = _mm512_add_epi64(s3, _mm512_popcnt_epi64(op(u, _mm512_loadu_si512(y3 + word))));
+        }
+
+        c0 = __sum_lanes(s0);
+        c1 = __sum_lanes(s1);
+        c2 = __sum_lanes(s2);
+        c3 = __sum_lanes(s3);
+#endif
+        for (; word < words; word++) {
+            uint64_t u = x[word];
+            c0 = c0 + __popcount(op(u, y0[word]));
+            c1 = c1 + __popcount(op(u, y1[word]));
+            c2 = c2 + __popcount(op(u, y2[word]));
+            c3 = c3 + __popcount(op(u, y3[word]));
+        }
+
+        counts[0] = c0;
+        counts[1] = c1;
+        counts[2] = c2;
+        counts[3] = c3;
+    }
+
+    // C(i, j) = popcount(op(a_i, b_j)) over the packed rows of a and b. The
+    // right operand is streamed in tiles of rows that stay cache resident
+    // while every row of the left operand passes over them.
+    template<typename Op>
+    matrix<uint32_t> __popcount_product(const bit_matrix& a, const bit_matrix& b, Op op) {
+#ifndef MATRIX_NOTHROW
+        if (a.columns() != b.columns()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        matrix<uint32_t> result(a.rows(), b.rows());
+        size_t words = a.words();
+        size_t tile = std::max<size_t>(4, (16384 / std::max<size_t>(words, 1)) / 4 * 4);
+
+        for (size_t j0 = 0; j0 < b.rows(); j0 += tile) {
+            size_t jn = std::min(tile, b.rows() - j0);
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(static)
+#endif
+            for (long long i = 0; i < static_cast<long long>(a.rows()); i++) {
+                uint64_t counts[4];
+
+                for (size_t j = j0; j < j0 + jn; j += 4) {
+                    size_t count = std::min<size_t>(4, j0 + jn - j);
+                    __popcount_kernel(a.row(i), b.row(j), count, words, words, op, counts);
+
+                    for (size_t k = 0; k < count; k++) {
+                        result(i, j + k) = static_cast<uint32_t>(counts[k]);
+                    }
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Number of columns set in both a_i and b_j: the integer product A B^T
+    // of two 0/1 matrices.
+    inline matrix<uint32_t> and_counts(const bit_matrix& a, const bit_matrix& b) {
+        matrix<uint32_t> result = __popcount_product(a, b, __bit_and());
+        return result;
+    }
+
+    // Hamming distances between the rows of a and the rows of b.
+    inline matrix<uint32_t> hamming_distances(const bit_matrix& a, const bit_matrix& b) {
+        matrix<uint32_t> result = __popcount_product(a, b, __bit_xor());
+        return result;
+    }
+
+    // Jaccard similarity |a_i & b_j| / |a_i | b_j| between rows; two empty
+    // rows are identical and score one.
+    inline matrix<double> jaccard_similarities(const bit_matrix& a, const bit_matrix& b) {
+        matrix<uint32_t> common = and_counts(a, b);
+        std::vector<uint32_t> left(a.rows());
+        std::vector<uint32_t> right(b.rows());
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t word = 0; word < a.words(); word++) {
+                left[row] = left[row] + __popcount(a.row(row)[word]);
+            }
+        }
+
+        for (size_t row = 0; row < b.rows(); row++) {
+            for (size_t word = 0; word < b.words(); word++) {
+                right[row] = right[row] + __popcount(b.row(row)[word]);
+            }
+        }
+
+        matrix<double> result(a.rows(), b.rows());
+        result.transform([&](size_t row, size_t column, double& value) {
+            uint32_t total = left[row] + right[column] - common(row, column);
+            value = (total == 0) ? 1.0 : double(common(row, column)) / double(total);
+        });
+
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,173 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_DISTANCE_H
+#define MATRIX_DISTANCE_H
+
+#include "matrix.h"
+
+#include <limits>
+
+namespace matrix {
+    enum class distance_metric {
+        squared_euclidean,
+        euclidean,
+        cosine
+    };
+
+    template<typename T>
+    struct neighbors {
+        matrix<size_t> indices;
+        matrix<T> distances;
+    };
+
+    template<typename T, bool Conjugate>
+    std::vector<std::remove_const_t<T>> __squared_row_norms(const matrix_view<T, Conjugate>& points) {
+        std::vector<std::remove_const_t<T>> result(points.rows());
+
+        for (size_t row = 0; row < points.rows(); row++) {
+            for (size_t column = 0; column < points.columns(); column++) {
+                result[row] = result[row] + points(row, column) * points(row, column);
+            }
+        }
+
+        return result;
+    }
+
+    // Distances between rows [row, row + tile.rows()) of x and
+    // [column, column + tile.columns()) of y from one GEMM for the inner
+    // products: |x|^2 - 2 x.y + |y|^2, or 1 - x.y / (|x| |y|).
+    template<typename T, typename VX, typename VY>
+    void __distance_tile(const VX& x, const VY& y, const std::vector<T>& x_norms, const std::vector<T>& y_norms, size_t row, size_t column, distance_metric metric, const matrix_view<T>& tile) {
+        size_t rows = tile.rows();
+        size_t columns = tile.columns();
+        gemm(T(1), x.block(row, 0, rows, x.columns()), y.block(column, 0, columns, y.columns()).t(), T(), tile);
+
+        for (size_t i = 0; i < rows; i++) {
+            for (size_t j = 0; j < columns; j++) {
+                T dot = tile(i, j);
+                T value;
+
+                if (metric == distance_metric::cosine) {
+                    T scale = std::sqrt(x_norms[row + i] * y_norms[column + j]);
+                    value = (scale > T()) ? T(1) - dot / scale : T(1);
+                } else {
+                    value = std::max(x_norms[row + i] - T(2) * dot + y_norms[column + j], T());
+                    value = (metric == distance_metric::euclidean) ? std::sqrt(value) : value;
+                }
+
+                tile(i, j) = value;
+            }
+        }
+    }
+
+    // Distances between every row of x and every row of y.
+    template<typename A, typename B>
+    auto pairwise_distances(const A& left, const B& right, distance_metric metric = distance_metric::squared_euclidean) {
+        auto x = __as_view(left);
+        auto y = __as_view(right);
+        using T = typename decltype(x)::value_type;
+#ifndef MATRIX_NOTHROW
+        if (x.columns() != y.columns()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        matrix<T> result(x.rows(), y.rows());
+        __distance_tile(x, y, __squared_row_norms(x), __squared_row_norms(y), 0, 0, metric, result.view());
+        return result;
+    }
+
+    // The `count` nearest rows of `points` to each row of `queries`, nearest
+    // first. Distances are computed a tile at a time and reduced straight
+    // into per-query bounded max-heaps, so the full distance matrix is never
+    // formed; query blocks run in parallel under OpenMP.
+    template<typename A, typename B>
+    auto nearest_neighbors(const A& queries, const B& points, size_t count, distance_metric metric = distance_metric::squared_euclidean) {
+        auto x = __as_view(queries);
+        auto y = __as_view(points);
+        using T = typename decltype(x)::value_type;
+        constexpr size_t query_block = 256;
+        constexpr size_t point_block = 2048;
+#ifndef MATRIX_NOTHROW
+        if (x.columns() != y.columns()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+
+        if ((count == 0) || (count > y.rows())) {
+            throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+        }
+#endif
+        std::vector<T> x_norms = __squared_row_norms(x);
+        std::vector<T> y_norms = __squared_row_norms(y);
+        neighbors<T> result = {matrix<size_t>(x.rows(), count), matrix<T>(x.rows(), count)};
+
+#ifdef _OPENMP
+#pragma omp parallel for schedule(dynamic)
+#endif
+        for (size_t q0 = 0; q0 < x.rows(); q0 += query_block) {
+            size_t rows = std::min(query_block, x.rows() - q0);
+            matrix<T> tile(rows, std::min(point_block, y.rows()));
+            std::vector<std::vector<std::pair<T, size_t>>> heaps(rows);
+
+            for (auto& heap : heaps) {
+                heap.reserve(count);
+            }
+
+            for (size_t p0 = 0; p0 < y.rows(); p0 += point_block) {
+                size_t columns = std::min(point_block, y.rows() - p0);
+                matrix_view<T> distances = tile.block(0, 0, rows, columns);
+                __distance_tile(x, y, x_norms, y_norms, q0, p0, metric, distances);
+
+                for (size_t i = 0; i < rows; i++) {
+                    auto& heap = heaps[i];
+
+                    for (size_t j = 0; j < columns; j++) {
+                        T value = distances(i, j);
+
+                        if (heap.size() < count) {
+                            heap.emplace_back(value, p0 + j);
+                            std::push_heap(heap.begin(), heap.end());
+                        } else if (value < heap.front().first) {
+                            std::pop_heap(heap.begin(), heap.end());
+                            heap.back() = std::make_pair(value, p0 + j);
+                            std::push_heap(heap.begin(), heap.end());
+                        }
+                    }
+                }
+            }
+
+            for (size_t i = 0; i < rows; i++) {
+                std::sort_heap(heaps[i].begin(), heaps[i].end());
+
+                for (size_t j = 0; j < count; j++) {
+                    result.distances(q0 + i, j) = heaps[i][j].first;
+                    result.indices(q0 + i, j) = heaps[i][j].second;
+                }
+            }
+        }
+
+        return result;
+    }
+}
+
+#endif
@@ -0,0 +1,1084 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_DISTRIBUTED_H
+#define MATRIX_DISTRIBUTED_H
+
+#include "matrix.h"
+
+#include <cerrno>
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace matrix {
+    // Point-to-point byte transport between the processes of a job. Messages
+    // between a pair of ranks are delivered in order; everything else
+    // (broadcasts, the distributed kernels) is built on send and receive.
+    class transport {
+    public:
+        virtual ~transport() = default;
+
+        virtual size_t rank() const = 0;
+        virtual size_t size() const = 0;
+        virtual void send(size_t destination, const void* data, size_t bytes) = 0;
+        virtual void receive(size_t source, void* data, size_t bytes) = 0;
+    };
+
+    // Reference transport over a full mesh of Unix domain sockets. Any set of
+    // connected stream sockets works, so the same class serves TCP meshes
+    // set up by a launcher on other nodes.
+    class socket_transport : public transport {
+    private:
+        size_t m_rank;
+        std::vector<int> m_peers;
+
+    public:
+        socket_transport(size_t rank, std::vector<int> peers) {
+            m_rank = rank;
+            m_peers = std::move(peers);
+        }
+
+        socket_transport(const socket_transport&) = delete;
+        socket_transport& operator=(const socket_transport&) = delete;
+
+        ~socket_transport() override {
+            for (int peer : m_peers) {
+                if (peer >= 0) {
+                    close(peer);
+                }
+            }
+        }
+
+        size_t rank() const override {
+            size_t result = m_rank;
+            return result;
+        }
+
+        size_t size() const override {
+            size_t result = m_peers.size();
+            return result;
+        }
+
+        void send(size_t destination, const void* data, size_t bytes) override {
+            const char* cursor = static_cast<const char*>(data);
+
+            while (bytes > 0) {
+                ssize_t written = ::send(m_peers[destination], cursor, bytes, MSG_NOSIGNAL);
+
+                if ((written < 0) && (errno == EINTR)) { continue; }
+#ifndef MATRIX_NOTHROW
+                if (written <= 0) {
+                    throw std::runtime_error(__error_messages[ERR_TRANSPORT]);
+                }
+#endif
+                cursor += written;
+                bytes -= static_cast<size_t>(written);
+            }
+        }
+
+        void receive(size_t source, void* data, size_t bytes) override {
+            char* cursor = static_cast<char*>(data);
+
+            while (bytes > 0) {
+                ssize_t read = ::recv(m_peers[source], cursor, bytes, 0);
+
+                if ((read < 0) && (errno == EINTR)) { continue; }
+#ifndef MATRIX_NOTHROW
+                if (read <= 0) {
+                    throw std::runtime_error(__error_messages[ERR_TRANSPORT]);
+                }
+#endif
+                cursor += read;
+                bytes -= static_cast<size_t>(read);
+            }
+        }
+
+        // Runs body(transport&) on `processes` local ranks: rank 0 in the
+        // calling process, the rest in forked children. Returns once every
+        // rank has finished and throws if any child failed.
+        template<typename F>
+        static void spawn(size_t processes, F&& body) {
+            std::vector<std::vector<int>> sockets(processes, std::vector<int>(processes, -1));
+            std::vector<pid_t> children;
+
+            for (size_t first = 0; first < processes; first++) {
+                for (size_t second = first + 1; second < processes; second++) {
+                    int pair[2];
+#ifndef MATRIX_NOTHROW
+                    if (socketpair(AF_UNIX, SOCK_STREAM, 0, pair) != 0) {
+                        throw std::runtime_error(__error_messages[ERR_TRANSPORT]);
+                    }
+#else
+                    socketpair(AF_UNIX, SOCK_STREAM, 0, pair);
+#endif
+                    sockets[first][second] = pair[0];
+                    sockets[second][first] = pair[1];
+                }
+            }
+
+            auto keep_only = [&](size_t rank) {
+                for (size_t owner = 0; owner < processes; owner++) {
+                    for (size_t peer = 0; peer < processes; peer++) {
+                        if ((owner != rank) && (sockets[owner][peer] >= 0)) {
+                            close(sockets[owner][peer]);
+                        }
+                    }
+                }
+            };
+
+            for (size_t rank = 1; rank < processes; rank++) {
+                pid_t child = fork();
+
+                if (child == 0) {
+                    int status = 0;
+                    keep_only(rank);
+
+                    try {
+                        socket_transport local(rank, sockets[rank]);
+                        body(static_cast<transport&>(local));
+                    } catch (...) {
+                        status = 1;
+                    }
+
+                    _exit(status);
+                }
+
+                children.push_back(child);
+            }
+
+            keep_only(0);
+            bool failed = false;
+
+            try {
+                socket_transport local(0, sockets[0]);
+                body(static_cast<transport&>(local));
+            } catch (...) {
+                for (pid_t child : children) {
+                    waitpid(child, nullptr, 0);
+                }
+
+                throw;
+            }
+
+            for (pid_t child : children) {
+                int status = 0;
+                waitpid(child, &status, 0);
+                failed = failed || !WIFEXITED(status) || (WEXITSTATUS(status) != 0);
+            }
+#ifndef MATRIX_NOTHROW
+            if (failed) {
+                throw std::runtime_error(__error_messages[ERR_TRANSPORT]);
+            }
+#endif
+        }
+    };
+
+    // Binomial-tree broadcast among `group` (ranks), rooted at group[root].
+    inline void broadcast(transport& channel, const std::vector<size_t>& group, size_t root, void* data, size_t bytes) {
+        size_t count = group.size();
+        size_t position = std::find(group.begin(), group.end(), channel.rank()) - group.begin();
+        size_t relative = (position + count - root) % count;
+        size_t mask = 1;
+
+        while (mask < count) {
+            if (relative & mask) {
+                channel.receive(group[(relative - mask + root) % count], data, bytes);
+                break;
+            }
+
+            mask <<= 1;
+        }
+
+        mask >>= 1;
+
+        while (mask > 0) {
+            if (relative + mask < count) {
+                channel.send(group[(relative + mask + root) % count], data, bytes);
+            }
+
+            mask >>= 1;
+        }
+    }
+
+    // P x Q process grid laid out row-major over the transport ranks.
+    class process_grid {
+    private:
+        transport* m_transport;
+        size_t m_rows;
+        size_t m_columns;
+
+    public:
+        process_grid(transport& channel, size_t rows, size_t columns) {
+#ifndef MATRIX_NOTHROW
+            if ((rows < 1) || (columns < 1) || (rows * columns != channel.size())) {
+                throw std::runtime_error(__error_messages[ERR_PROCESS_GRID]);
+            }
+#endif
+            m_transport = &channel;
+            m_rows = rows;
+            m_columns = columns;
+        }
+
+        transport& channel() const {
+            transport& result = *m_transport;
+            return result;
+        }
+
+        size_t rows() const {
+            size_t result = m_rows;
+            return result;
+        }
+
+        size_t columns() const {
+            size_t result = m_columns;
+            return result;
+        }
+
+        size_t row() const {
+            size_t result = m_transport->rank() / m_columns;
+            return result;
+        }
+
+        size_t column() const {
+            size_t result = m_transport->rank() % m_columns;
+            return result;
+        }
+
+        size_t rank(size_t row, size_t column) const {
+            size_t result = row * m_columns + column;
+            return result;
+        }
+
+        std::vector<size_t> row_group() const {
+            std::vector<size_t> result;
+
+            for (size_t column = 0; column < m_columns; column++) {
+                result.push_back(rank(row(), column));
+            }
+
+            return result;
+        }
+
+        std::vector<size_t> column_group() const {
+            std::vector<size_t> result;
+
+            for (size_t row = 0; row < m_rows; row++) {
+                result.push_back(rank(row, column()));
+            }
+
+            return result;
+        }
+    };
+
+    // Number of rows (or columns) of an n-long dimension, cut into blocks of
+    // `block`, that land on process `index` of `count` (ScaLAPACK's NUMROC).
+    inline size_t __local_extent(size_t n, size_t block, size_t index, size_t count) {
+        size_t blocks = n / block;
+        size_t result = (blocks / count) * block;
+        size_t extra = blocks % count;
+
+        if (index < extra) {
+            result += block;
+        } else if (index == extra) {
+            result += n % block;
+        }
+
+        return result;
+    }
+
+    // Global index of local index `local` on process `index` of `count`.
+    inline size_t __global_index(size_t local, size_t block, size_t index, size_t count) {
+        size_t result = ((local / block) * count + index) * block + local % block;
+        return result;
+    }
+
+    template<typename T>
+    matrix<T> __local_matrix(size_t rows, size_t columns) {
+        matrix<T> result;
+
+        if ((rows > 0) && (columns > 0)) {
+            result = matrix<T>(rows, columns);
+        }
+
+        return result;
+    }
+
+    // Global rows x columns matrix in 2D block-cyclic layout: block (I, J) of
+    // size block_rows x block_columns lives on process (I mod P, J mod Q), and
+    // each process keeps its blocks packed in one local matrix<T>.
+    template<typename T>
+    class distributed_matrix {
+        static_assert(std::is_trivially_copyable_v<T>, "distributed elements must be trivially copyable.");
+
+    private:
+        process_grid m_grid;
+        size_t m_rows;
+        size_t m_columns;
+        size_t m_block_rows;
+        size_t m_block_columns;
+        size_t m_local_rows;
+        size_t m_local_columns;
+        matrix<T> m_local;
+
+    public:
+        distributed_matrix(const process_grid& grid, size_t rows, size_t columns, size_t block_rows, size_t block_columns) : m_grid(grid) {
+#ifndef MATRIX_NOTHROW
+            if ((rows < 1) || (columns < 1) || (block_rows < 1) || (block_columns < 1)) {
+                throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+            }
+#endif
+            m_rows = rows;
+            m_columns = columns;
+            m_block_rows = block_rows;
+            m_block_columns = block_columns;
+            m_local_rows = __local_extent(rows, block_rows, grid.row(), grid.rows());
+            m_local_columns = __local_extent(columns, block_columns, grid.column(), grid.columns());
+            m_local = __local_matrix<T>(m_local_rows, m_local_columns);
+        }
+
+        const process_grid& grid() const {
+            const process_grid& result = m_grid;
+            return result;
+        }
+
+        size_t rows() const {
+            size_t result = m_rows;
+            return result;
+        }
+
+        size_t columns() const {
+            size_t result = m_columns;
+            return result;
+        }
+
+        size_t block_rows() const {
+            size_t result = m_block_rows;
+            return result;
+        }
+
+        size_t block_columns() const {
+            size_t result = m_block_columns;
+            return result;
+        }
+
+        // True extents of this process's share; local() collapses to 0 x 0
+        // when either of them is zero.
+        size_t local_rows() const {
+            size_t result = m_local_rows;
+            return result;
+        }
+
+        size_t local_columns() const {
+            size_t result = m_local_columns;
+            return result;
+        }
+
+        matrix<T>& local() {
+            matrix<T>& result = m_local;
+            return result;
+        }
+
+        const matrix<T>& local() const {
+            const matrix<T>& result = m_local;
+            return result;
+        }
+
+        size_t row_owner(size_t row) const {
+            size_t result = (row / m_block_rows) % m_grid.rows();
+            return result;
+        }
+
+        size_t column_owner(size_t column) const {
+            size_t result = (column / m_block_columns) % m_grid.columns();
+            return result;
+        }
+
+        size_t local_row(size_t row) const {
+            size_t result = (row / m_block_rows / m_grid.rows()) * m_block_rows + row % m_block_rows;
+            return result;
+        }
+
+        size_t local_column(size_t column) const {
+            size_t result = (column / m_block_columns / m_grid.columns()) * m_block_columns + column % m_block_columns;
+            return result;
+        }
+
+        size_t global_row(size_t local_row) const {
+            size_t result = __global_index(local_row, m_block_rows, m_grid.row(), m_grid.rows());
+            return result;
+        }
+
+        size_t global_column(size_t local_column) const {
+            size_t result = __global_index(local_column, m_block_columns, m_grid.column(), m_grid.columns());
+            return result;
+        }
+
+        // Sets every local element from a function of its global position.
+        template<typename L>
+        distributed_matrix<T>& transform(L&& lambda) {
+            for (size_t row = 0; row < m_local.rows(); row++) {
+                for (size_t column = 0; column < m_local.columns(); column++) {
+                    lambda(global_row(row), global_column(column), m_local(row, column));
+                }
+            }
+
+            return (*this);
+        }
+
+        // Assembles the global matrix on `root`; other ranks get an empty one.
+        matrix<T> gather(size_t root = 0) const {
+            transport& channel = m_grid.channel();
+            matrix<T> result;
+
+            if (channel.rank() != root) {
+                channel.send(root, m_local.data(), m_local.size() * sizeof(T));
+                return result;
+            }
+
+            result = matrix<T>(m_rows, m_columns);
+
+            for (size_t source = 0; source < channel.size(); source++) {
+                size_t grid_row = source / m_grid.columns();
+                size_t grid_column = source % m_grid.columns();
+                size_t local_rows = __local_extent(m_rows, m_block_rows, grid_row, m_grid.rows());
+                size_t local_columns = __local_extent(m_columns, m_block_columns, grid_column, m_grid.columns());
+                std::vector<T> buffer(local_rows * local_columns);
+
+                if (source == root) {
+                    std::copy(m_local.data(), m_local.data() + buffer.size(), buffer.begin());
+                } else {
+                    channel.receive(source, buffer.data(), buffer.size() * sizeof(T));
+                }
+
+                for (size_t row = 0; row < local_rows; row++) {
+                    size_t global = __global_index(row, m_block_rows, grid_row, m_grid.rows());
+
+                    for (size_t column = 0; column < local_columns; column++) {
+                        size_t global_column = __global_index(column, m_block_columns, grid_column, m_grid.columns());
+                        result(global, global_column) = buffer[row * local_columns + column];
+                    }
+                }
+            }
+
+            return result;
+        }
+    };
+
+    // Broadcasts the local columns [offset, offset + width) of `source` from
+    // grid column `root` along each process row (or the local rows along each
+    // process column when `along_rows` is false) and returns the packed panel.
+    template<typename T>
+    matrix<T> __broadcast_panel(const distributed_matrix<T>& source, bool along_rows, size_t root, size_t offset, size_t width) {
+        const process_grid& grid = source.grid();
+        const matrix<T>& local = source.local();
+        bool owner = along_rows ? (grid.column() == root) : (grid.row() == root);
+        size_t rows = along_rows ? __local_extent(source.rows(), source.block_rows(), grid.row(), grid.rows()) : width;
+        size_t columns = along_rows ? width : __local_extent(source.columns(), source.block_columns(), grid.column(), grid.columns());
+        matrix<T> result = __local_matrix<T>(rows, columns);
+
+        if (result.size() == 0) {
+            return result;
+        }
+
+        if (owner) {
+            matrix_view<const T> panel = along_rows ? local.block(0, offset, rows, width) : local.block(offset, 0, width, columns);
+            result = matrix<T>(panel);
+        }
+
+        broadcast(grid.channel(), along_rows ? grid.row_group() : grid.column_group(), root, result.data(), result.size() * sizeof(T));
+        return result;
+    }
+
+    // SUMMA: C = A * B. For each block column k of A (block row k of B) the
+    // owning process column broadcasts its A panel along process rows, the
+    // owning process row broadcasts its B panel along process columns, and
+    // every process accumulates the local product with gemm.
+    template<typename T>
+    distributed_matrix<T> summa(const distributed_matrix<T>& a, const distributed_matrix<T>& b) {
+#ifndef MATRIX_NOTHROW
+        if ((a.columns() != b.rows()) || (a.block_columns() != b.block_rows())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+
+        if ((a.grid().rows() != b.grid().rows()) || (a.grid().columns() != b.grid().columns())) {
+            throw std::runtime_error(__error_messages[ERR_PROCESS_GRID]);
+        }
+#endif
+        const process_grid& grid = a.grid();
+        distributed_matrix<T> result(grid, a.rows(), b.columns(), a.block_rows(), b.block_columns());
+        size_t block = a.block_columns();
+
+        for (size_t k = 0; k * block < a.columns(); k++) {
+            size_t width = std::min(block, a.columns() - k * block);
+            size_t offset = (k / grid.columns()) * block;
+            size_t offset_b = (k / grid.rows()) * block;
+            matrix<T> panel_a = __broadcast_panel(a, true, k % grid.columns(), offset, width);
+            matrix<T> panel_b = __broadcast_panel(b, false, k % grid.rows(), offset_b, width);
+
+            if ((result.local().size() > 0) && (panel_a.size() > 0) && (panel_b.size() > 0)) {
+                gemm(T(1), panel_a.view(), panel_b.view(), T(1), result.local().view());
+            }
+        }
+
+        return result;
+    }
+
+    // Pairwise exchange ordered by rank so neither side can block the other.
+    inline void __exchange(transport& channel, size_t peer, const void* outgoing, void* incoming, size_t bytes) {
+        if (channel.rank() < peer) {
+            channel.send(peer, outgoing, bytes);
+            channel.receive(peer, incoming, bytes);
+        } else {
+            channel.receive(peer, incoming, bytes);
+            channel.send(peer, outgoing, bytes);
+        }
+    }
+
+    // Swaps global rows `first` and `second` across every local column except
+    // [skip, skip + skip_count); owners in different process rows trade their
+    // segments within the process column.
+    template<typename T>
+    void __swap_rows(distributed_matrix<T>& operand, size_t first, size_t second, size_t skip, size_t skip_count) {
+        const process_grid& grid = operand.grid();
+        matrix<T>& local = operand.local();
+        size_t first_owner = operand.row_owner(first);
+        size_t second_owner = operand.row_owner(second);
+        size_t columns = operand.local_columns();
+
+        if (((grid.row() != first_owner) && (grid.row() != second_owner)) || (columns == 0)) {
+            return;
+        }
+
+        auto is_skipped = [&](size_t column) {
+            return (column >= skip) && (column < skip + skip_count);
+        };
+
+        if (first_owner == second_owner) {
+            T* a = local.data() + operand.local_row(first) * columns;
+            T* b = local.data() + operand.local_row(second) * columns;
+
+            for (size_t column = 0; column < columns; column++) {
+                if (!is_skipped(column)) {
+                    std::swap(a[column], b[column]);
+                }
+            }
+
+            return;
+        }
+
+        bool holds_first = (grid.row() == first_owner);
+        T* row = local.data() + operand.local_row(holds_first ? first : second) * columns;
+        size_t peer = grid.rank(holds_first ? second_owner : first_owner, grid.column());
+        std::vector<T> outgoing;
+        std::vector<T> incoming;
+
+        for (size_t column = 0; column < columns; column++) {
+            if (!is_skipped(column)) {
+                outgoing.push_back(row[column]);
+            }
+        }
+
+        incoming.resize(outgoing.size());
+        __exchange(grid.channel(), peer, outgoing.data(), incoming.data(), outgoing.size() * sizeof(T));
+        size_t index = 0;
+
+        for (size_t column = 0; column < columns; column++) {
+            if (!is_skipped(column)) {
+                row[column] = incoming[index++];
+            }
+        }
+    }
+
+    // Collective over the process column owning block column k: gathers the
+    // panel (global rows from k * block down) onto the diagonal process,
+    // factors it there, broadcasts it back down the column and stores each
+    // process's rows. For LU the panel pivots are recorded as global rows.
+    template<typename T>
+    matrix<T> __factor_panel(distributed_matrix<T>& operand, size_t k, std::vector<size_t>& pivots, bool symmetric) {
+        const process_grid& grid = operand.grid();
+        transport& channel = grid.channel();
+        size_t n = operand.rows();
+        size_t block = operand.block_rows();
+        size_t first = k * block;
+        size_t width = std::min(block, n - first);
+        size_t root = k % grid.rows();
+        size_t column = operand.local_column(first);
+        size_t start = __local_extent(first, block, grid.row(), grid.rows());
+        size_t count = operand.local_rows() - start;
+        matrix<T> result(n - first, width);
+        std::vector<size_t> panel_pivots(width);
+
+        if (grid.row() == root) {
+            for (size_t source = 0; source < grid.rows(); source++) {
+                size_t source_start = __local_extent(first, block, source, grid.rows());
+                size_t source_count = __local_extent(n, block, source, grid.rows()) - source_start;
+                matrix<T> rows = __local_matrix<T>(source_count, width);
+
+                if (source_count == 0) { continue; }
+
+                if (source == root) {
+                    rows = matrix<T>(operand.local().block(start, column, count, width));
+                } else {
+                    channel.receive(grid.rank(source, grid.column()), rows.data(), rows.size() * sizeof(T));
+                }
+
+                for (size_t row = 0; row < source_count; row++) {
+                    size_t global = __global_index(source_start + row, block, source, grid.rows());
+                    std::copy(rows.data() + row * width, rows.data() + (row + 1) * width, result.data() + (global - first) * width);
+                }
+            }
+
+            if (symmetric) {
+                __cholesky_step(result.view(), 0, width);
+
+                for (size_t row = 0; row < width; row++) {
+                    for (size_t entry = row + 1; entry < width; entry++) {
+                        result(row, entry) = T();
+                    }
+                }
+            } else {
+                __lu_step(result.view(), 0, width, panel_pivots);
+            }
+
+            for (size_t index = 0; index < width; index++) {
+                panel_pivots[index] = panel_pivots[index] + first;
+            }
+        } else if (count > 0) {
+            matrix<T> rows(operand.local().block(start, column, count, width));
+            channel.send(grid.rank(root, grid.column()), rows.data(), rows.size() * sizeof(T));
+        }
+
+        broadcast(channel, grid.column_group(), root, result.data(), result.size() * sizeof(T));
+
+        if (!symmetric) {
+            broadcast(channel, grid.column_group(), root, panel_pivots.data(), width * sizeof(size_t));
+            std::copy(panel_pivots.begin(), panel_pivots.end(), pivots.begin() + first);
+        }
+
+        for (size_t row = start; row < operand.local_rows(); row++) {
+            size_t global = operand.global_row(row);
+            std::copy(result.data() + (global - first) * width, result.data() + (global - first + 1) * width, operand.local().data() + row * operand.local_columns() + column);
+        }
+
+        return result;
+    }
+
+    // Broadcasts the factored panel k (and its pivots) from its process
+    // column along every process row. The owning column calls this as soon
+    // as it has factored the panel, so its sends leave before its trailing
+    // update; the other columns join at the top of step k.
+    template<typename T>
+    matrix<T> __share_panel(const distributed_matrix<T>& operand, size_t k, matrix<T> panel, std::vector<size_t>& pivots, bool symmetric) {
+        const process_grid& grid = operand.grid();
+        size_t n = operand.rows();
+        size_t block = operand.block_rows();
+        size_t first = k * block;
+        size_t width = std::min(block, n - first);
+        size_t root = k % grid.columns();
+
+        if (grid.column() != root) {
+            panel = matrix<T>(n - first, width);
+        }
+
+        broadcast(grid.channel(), grid.row_group(), root, panel.data(), panel.size() * sizeof(T));
+
+        if (!symmetric) {
+            broadcast(grid.channel(), grid.row_group(), root, pivots.data() + first, width * sizeof(size_t));
+        }
+
+        return panel;
+    }
+
+    // Rows of a shared panel (global rows from `first` down) matching the
+    // given local indices of this process's rows or columns.
+    template<typename T>
+    matrix<T> __panel_rows(const matrix<T>& panel, size_t first, size_t start, size_t count, size_t block, size_t index, size_t processes) {
+        matrix<T> result = __local_matrix<T>(count, panel.columns());
+
+        for (size_t row = 0; row < count; row++) {
+            size_t global = __global_index(start + row, block, index, processes);
+            std::copy(panel.data() + (global - first) * panel.columns(), panel.data() + (global - first + 1) * panel.columns(), result.data() + row * panel.columns());
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    void __check_distributed_square(const distributed_matrix<T>& operand) {
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+
+        if (operand.block_rows() != operand.block_columns()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+    }
+
+    // Forward (lower) or backward (upper) block substitution of B against the
+    // triangular factor stored in `factors`. Each step broadcasts the factor's
+    // block column along process rows, solves the diagonal block on the owning
+    // process row, broadcasts the solution down process columns and updates
+    // the remaining rows with a local gemm.
+    template<typename T>
+    void __distributed_substitution(const distributed_matrix<T>& factors, distributed_matrix<T>& b, bool lower, bool unit) {
+        const process_grid& grid = factors.grid();
+        size_t n = factors.rows();
+        size_t block = factors.block_rows();
+        size_t panels = (n + block - 1) / block;
+        matrix<T>& local = b.local();
+
+        for (size_t step = 0; step < panels; step++) {
+            size_t k = lower ? step : panels - 1 - step;
+            size_t first = k * block;
+            size_t width = std::min(block, n - first);
+            size_t row_root = k % grid.rows();
+            size_t column_root = k % grid.columns();
+            size_t diagonal = __local_extent(first, block, grid.row(), grid.rows());
+            size_t begin = lower ? diagonal : 0;
+            size_t end = lower ? factors.local_rows() : __local_extent(first + width, block, grid.row(), grid.rows());
+            matrix<T> panel = __local_matrix<T>(end - begin, width);
+
+            if ((grid.column() == column_root) && (panel.size() > 0)) {
+                panel = matrix<T>(factors.local().block(begin, factors.local_column(first), end - begin, width));
+            }
+
+            if (panel.size() > 0) {
+                broadcast(grid.channel(), grid.row_group(), column_root, panel.data(), panel.size() * sizeof(T));
+            }
+
+            matrix<T> solution = __local_matrix<T>(width, b.local_columns());
+
+            if (solution.size() == 0) {
+                continue;
+            }
+
+            if (grid.row() == row_root) {
+                size_t offset = diagonal - begin;
+                solution = matrix<T>(local.block(diagonal, 0, width, local.columns()));
+
+                if (lower) {
+                    __solve_lower(panel.block(offset, 0, width, width), unit, solution);
+                } else {
+                    __solve_upper(panel.block(offset, 0, width, width), unit, solution);
+                }
+
+                std::copy(solution.data(), solution.data() + solution.size(), local.data() + diagonal * local.columns());
+            }
+
+            broadcast(grid.channel(), grid.column_group(), row_root, solution.data(), solution.size() * sizeof(T));
+            size_t update_begin = lower ? __local_extent(first + width, block, grid.row(), grid.rows()) : 0;
+            size_t update_end = lower ? b.local_rows() : diagonal;
+
+            if (update_end > update_begin) {
+                gemm(T(-1), panel.block(update_begin - begin, 0, update_end - update_begin, width), solution.view(), T(1), local.block(update_begin, 0, update_end - update_begin, local.columns()));
+            }
+        }
+    }
+
+    template<typename T>
+    class distributed_lu_factorization {
+    private:
+        distributed_matrix<T> m_factors;
+        std::vector<size_t> m_pivots;
+
+    public:
+        distributed_lu_factorization(distributed_matrix<T> factors, std::vector<size_t> pivots) : m_factors(std::move(factors)) {
+            m_pivots = std::move(pivots);
+        }
+
+        const distributed_matrix<T>& factors() const {
+            const distributed_matrix<T>& result = m_factors;
+            return result;
+        }
+
+        const std::vector<size_t>& pivots() const {
+            const std::vector<size_t>& result = m_pivots;
+            return result;
+        }
+
+        // The P of P * A = L * U.
+        permutation row_permutation() const {
+            permutation result = permutation::from_swaps(m_pivots);
+            return result;
+        }
+
+        // B must share the grid and use the factor's block size for its rows.
+        distributed_matrix<T> solve(const distributed_matrix<T>& operand) const {
+#ifndef MATRIX_NOTHROW
+            if ((operand.rows() != m_factors.rows()) || (operand.block_rows() != m_factors.block_rows())) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            distributed_matrix<T> result(operand);
+
+            for (size_t index = 0; index < m_pivots.size(); index++) {
+                if (m_pivots[index] != index) {
+                    __swap_rows(result, index, m_pivots[index], 0, 0);
+                }
+            }
+
+            __distributed_substitution(m_factors, result, true, true);
+            __distributed_substitution(m_factors, result, false, false);
+            return result;
+        }
+    };
+
+    template<typename T>
+    class distributed_cholesky_factorization {
+    private:
+        distributed_matrix<T> m_factor;
+
+    public:
+        distributed_cholesky_factorization(distributed_matrix<T> factor) : m_factor(std::move(factor)) {
+
+        }
+
+        const distributed_matrix<T>& factor() const {
+            const distributed_matrix<T>& result = m_factor;
+            return result;
+        }
+
+        // Forward substitution with L, then L^H x = y in dot-product form:
+        // x_k = L_kk^-H (y_k - sum over i > k of L_ik^H x_i), where the sum
+        // is reduced over the process column onto the owner of block row k.
+        distributed_matrix<T> solve(const distributed_matrix<T>& operand) const {
+#ifndef MATRIX_NOTHROW
+            if ((operand.rows() != m_factor.rows()) || (operand.block_rows() != m_factor.block_rows())) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            distributed_matrix<T> result(operand);
+            __distributed_substitution(m_factor, result, true, false);
+
+            const process_grid& grid = m_factor.grid();
+            transport& channel = grid.channel();
+            size_t n = m_factor.rows();
+            size_t block = m_factor.block_rows();
+            size_t panels = (n + block - 1) / block;
+            matrix<T>& local = result.local();
+
+            for (size_t k = panels; k-- > 0;) {
+                size_t first = k * block;
+                size_t width = std::min(block, n - first);
+                size_t row_root = k % grid.rows();
+                size_t column_root = k % grid.columns();
+                size_t diagonal = __local_extent(first, block, grid.row(), grid.rows());
+                size_t below = __local_extent(first + width, block, grid.row(), grid.rows());
+                matrix<T> panel = __local_matrix<T>(m_factor.local_rows() - diagonal, width);
+
+                if ((grid.column() == column_root) && (panel.size() > 0)) {
+                    panel = matrix<T>(m_factor.local().block(diagonal, m_factor.local_column(first), panel.rows(), width));
+                }
+
+                if (panel.size() > 0) {
+                    broadcast(channel, grid.row_group(), column_root, panel.data(), panel.size() * sizeof(T));
+                }
+
+                if (result.local_columns() == 0) {
+                    continue;
+                }
+
+                matrix<T> sum(width, result.local_columns());
+
+                if (result.local_rows() > below) {
+                    gemm(T(1), panel.block(below - diagonal, 0, local.rows() - below, width).h(), local.block(below, 0, local.rows() - below, local.columns()), T(), sum.view());
+                }
+
+                if (grid.row() == row_root) {
+                    matrix<T> partial(width, result.local_columns());
+
+                    for (size_t source = 0; source < grid.rows(); source++) {
+                        if (source == row_root) { continue; }
+
+                        channel.receive(grid.rank(source, grid.column()), partial.data(), partial.size() * sizeof(T));
+                        sum = sum + partial;
+                    }
+
+                    matrix<T> solution = matrix<T>(local.block(diagonal, 0, width, local.columns())) - sum;
+                    __solve_upper(panel.block(0, 0, width, width).h(), false, solution);
+                    std::copy(solution.data(), solution.data() + solution.size(), local.data() + diagonal * local.columns());
+                } else {
+                    channel.send(grid.rank(row_root, grid.column()), sum.data(), sum.size() * sizeof(T));
+                }
+            }
+
+            return result;
+        }
+    };
+
+    // Right-looking LU with partial pivoting over the block-cyclic layout
+    // (square blocks). Each panel is factored on its process column and
+    // broadcast along process rows; U is formed on the diagonal process row
+    // and broadcast down process columns; the trailing update is a local
+    // gemm. With one step of lookahead, the next panel's columns are updated
+    // and that panel is factored and sent before the bulk of the trailing
+    // update. The transport is blocking, so the sends overlap the owner's
+    // gemm only as far as the socket buffers absorb them; the receivers pick
+    // the panel up after their own update.
+    template<typename T>
+    distributed_lu_factorization<T> lu(const distributed_matrix<T>& operand) {
+        __check_distributed_square(operand);
+
+        distributed_matrix<T> factors(operand);
+        const process_grid& grid = factors.grid();
+        size_t n = factors.rows();
+        size_t block = factors.block_rows();
+        size_t panels = (n + block - 1) / block;
+        std::vector<size_t> pivots(n);
+        matrix<T> panel;
+
+        if (grid.column() == 0) {
+            panel = __factor_panel(factors, 0, pivots, false);
+            panel = __share_panel(factors, 0, std::move(panel), pivots, false);
+        }
+
+        for (size_t k = 0; k < panels; k++) {
+            size_t first = k * block;
+            size_t width = std::min(block, n - first);
+            size_t next = first + width;
+            bool panel_column = (grid.column() == k % grid.columns());
+
+            if (!panel_column) {
+                panel = __share_panel(factors, k, std::move(panel), pivots, false);
+            }
+
+            for (size_t index = first; index < next; index++) {
+                if (pivots[index] != index) {
+                    __swap_rows(factors, index, pivots[index], panel_column ? factors.local_column(first) : 0, panel_column ? width : 0);
+                }
+            }
+
+            matrix<T>& local = factors.local();
+            size_t row_start = __local_extent(next, block, grid.row(), grid.rows());
+            size_t column_start = __local_extent(next, block, grid.column(), grid.columns());
+            size_t rows = factors.local_rows() - row_start;
+            size_t columns = factors.local_columns() - column_start;
+            matrix<T> upper = __local_matrix<T>(width, columns);
+
+            if (columns > 0) {
+                if (grid.row() == k % grid.rows()) {
+                    size_t diagonal = factors.local_row(first);
+                    upper = matrix<T>(local.block(diagonal, column_start, width, columns));
+                    __solve_lower(panel.block(0, 0, width, width), true, upper);
+
+                    for (size_t row = 0; row < width; row++) {
+                        std::copy(upper.data() + row * columns, upper.data() + (row + 1) * columns, local.data() + (diagonal + row) * local.columns() + column_start);
+                    }
+                }
+
+                broadcast(grid.channel(), grid.column_group(), k % grid.rows(), upper.data(), upper.size() * sizeof(T));
+            }
+
+            matrix<T> lower = __panel_rows(panel, first, row_start, rows, block, grid.row(), grid.rows());
+            size_t ahead = 0;
+
+            auto update = [&](size_t from, size_t to) {
+                if ((rows > 0) && (to > from)) {
+                    gemm(T(-1), lower.view(), upper.block(0, from, width, to - from), T(1), local.block(row_start, column_start + from, rows, to - from));
+                }
+            };
+
+            if ((k + 1 < panels) && (grid.column() == (k + 1) % grid.columns())) {
+                ahead = std::min(block, n - next);
+                update(0, ahead);
+                panel = __factor_panel(factors, k + 1, pivots, false);
+                panel = __share_panel(factors, k + 1, std::move(panel), pivots, false);
+            }
+
+            update(ahead, columns);
+        }
+
+        distributed_lu_factorization<T> result(std::move(factors), std::move(pivots));
+        return result;
+    }
+
+    // Right-looking Cholesky (A = L * L^H) with the same panel broadcast and
+    // lookahead scheme as the LU; each process takes the panel rows matching
+    // both its local rows and its local columns for the trailing update.
+    template<typename T>
+    distributed_cholesky_factorization<T> cholesky(const distributed_matrix<T>& operand) {
+        __check_distributed_square(operand);
+
+        distributed_matrix<T> factor(operand);
+        const process_grid& grid = factor.grid();
+        size_t n = factor.rows();
+        size_t block = factor.block_rows();
+        size_t panels = (n + block - 1) / block;
+        std::vector<size_t> unused;
+        matrix<T> panel;
+
+        if (grid.column() == 0) {
+            panel = __factor_panel(factor, 0, unused, true);
+            panel = __share_panel(factor, 0, std::move(panel), unused, true);
+        }
+
+        for (size_t k = 0; k < panels; k++) {
+            size_t first = k * block;
+            size_t width = std::min(block, n - first);
+            size_t next = first + width;
+
+            if (grid.column() != k % grid.columns()) {
+                panel = __share_panel(factor, k, std::move(panel), unused, true);
+            }
+
+            matrix<T>& local = factor.local();
+            size_t row_start = __local_extent(next, block, grid.row(), grid.rows());
+            size_t column_start = __local_extent(next, block, grid.column(), grid.columns());
+            size_t rows = factor.local_rows() - row_start;
+            size_t columns = factor.local_columns() - column_start;
+            matrix<T> lower = __panel_rows(panel, first, row_start, rows, block, grid.row(), grid.rows());
+            matrix<T> transposed = __panel_rows(panel, first, column_start, columns, block, grid.column(), grid.columns());
+            size_t ahead = 0;
+
+            auto update = [&](size_t from, size_t to) {
+                if ((rows > 0) && (to > from)) {
+                    gemm(T(-1), lower.view(), transposed.block(from, 0, to - from, width).h(), T(1), local.block(row_start, column_start + from, rows, to - from));
+                }
+            };
+
+            if ((k + 1 < panels) && (grid.column() == (k + 1) % grid.columns())) {
+                ahead = std::min(block, n - next);
+                update(0, ahead);
+                panel = __factor_panel(factor, k + 1, unused, true);
+                panel = __share_panel(factor, k + 1, std::move(panel), unused, true);
+            }
+
+            update(ahead, columns);
+        }
+
+        factor.transform([](size_t row, size_t column, T& element) {
+            if (column > row) {
+                element = T();
+            }
+        });
+
+        distributed_cholesky_factorization<T> result(std::move(factor));
+        return result;
+    }
+}
+
+#endif
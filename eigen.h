@@ -0,0 +1,1521 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_EIGEN_H
+#define MATRIX_EIGEN_H
+
+#include "iterative.h"
+
+#include <limits>
+#include <numeric>
+#include <random>
+
+namespace matrix {
+    enum class eigen_selection {
+        largest_magnitude,
+        smallest_magnitude,
+        largest_real,
+        smallest_real
+    };
+
+    // max_restarts bounds the Krylov-Schur restarts of lanczos and arnoldi;
+    // max_iterations bounds the block iterations of lobpcg.
+    struct eigen_options {
+        eigen_selection which = eigen_selection::largest_magnitude;
+        size_t subspace = 0;
+        size_t block_size = 1;
+        size_t max_restarts = 500;
+        size_t max_iterations = 500;
+        double tolerance = 1e-10;
+        unsigned seed = 1;
+    };
+
+    template<typename T>
+    struct eigen_result {
+        matrix<T> values;
+        matrix<T> vectors;
+        size_t converged;
+        size_t restarts;
+        size_t iterations;
+    };
+
+    // Operator (A - shift I)^-1 applied through an LU factorization. The
+    // Krylov solvers recognise it, look for the eigenvalues closest to the
+    // shift and map them back to the spectrum of A.
+    template<typename T>
+    class shift_invert {
+    private:
+        lu_factorization<T> m_factorization;
+        T m_shift;
+
+        template<size_t Rows, size_t Columns>
+        static matrix<T> __shifted(const matrix<T, Rows, Columns>& a, T shift) {
+            matrix<T> result = a;
+
+            for (size_t index = 0; index < std::min(result.rows(), result.columns()); index++) {
+                result(index, index) = result(index, index) - shift;
+            }
+
+            return result;
+        }
+
+    public:
+        template<size_t Rows, size_t Columns>
+        shift_invert(const matrix<T, Rows, Columns>& a, T shift) : m_factorization(lu(__shifted(a, shift))), m_shift(shift) {}
+
+        size_t rows() const {
+            size_t result = m_factorization.factors().rows();
+            return result;
+        }
+
+        T shift() const {
+            T result = m_shift;
+            return result;
+        }
+
+        matrix<T> operator()(const matrix<T>& operand) const {
+            matrix<T> result = m_factorization.solve(operand);
+            return result;
+        }
+    };
+
+    template<typename T>
+    struct __is_shift_invert : std::false_type {};
+
+    template<typename T>
+    struct __is_shift_invert<shift_invert<T>> : std::true_type {};
+
+    // Eigenpairs of the small dense symmetric matrices produced by projection:
+    // Householder tridiagonalization followed by the implicit QL iteration
+    // (the EISPACK tred2/tql2 pair). Values come out ascending, with the
+    // eigenvectors as the columns of `vectors`.
+    template<typename T>
+    void __symmetric_eigen(const matrix<T>& a, std::vector<T>& values, matrix<T>& vectors) {
+        size_t n = a.rows();
+        vectors = a;
+        values.assign(n, T());
+        std::vector<T> e(n);
+        T* v = vectors.data();
+        std::vector<T>& d = values;
+
+        if (n == 0) {
+            return;
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            d[j] = v[(n - 1) * n + j];
+        }
+
+        for (size_t i = n - 1; i > 0; i--) {
+            T scale = T();
+            T h = T();
+
+            for (size_t k = 0; k < i; k++) {
+                scale = scale + std::abs(d[k]);
+            }
+
+            if (scale == T()) {
+                e[i] = d[i - 1];
+
+                for (size_t j = 0; j < i; j++) {
+                    d[j] = v[(i - 1) * n + j];
+                    v[i * n + j] = T();
+                    v[j * n + i] = T();
+                }
+            } else {
+                for (size_t k = 0; k < i; k++) {
+                    d[k] = d[k] / scale;
+                    h = h + d[k] * d[k];
+                }
+
+                T f = d[i - 1];
+                T g = (f > T()) ? -std::sqrt(h) : std::sqrt(h);
+                e[i] = scale * g;
+                h = h - f * g;
+                d[i - 1] = f - g;
+
+                for (size_t j = 0; j < i; j++) {
+                    e[j] = T();
+                }
+
+                for (size_t j = 0; j < i; j++) {
+                    f = d[j];
+                    v[j * n + i] = f;
+                    g = e[j] + v[j * n + j] * f;
+
+                    for (size_t k = j + 1; k < i; k++) {
+                        g = g + v[k * n + j] * d[k];
+                        e[k] = e[k] + v[k * n + j] * f;
+                    }
+
+                    e[j] = g;
+                }
+
+                f = T();
+
+                for (size_t j = 0; j < i; j++) {
+                    e[j] = e[j] / h;
+                    f = f + e[j] * d[j];
+                }
+
+                T hh = f / (h + h);
+
+                for (size_t j = 0; j < i; j++) {
+                    e[j] = e[j] - hh * d[j];
+                }
+
+                for (size_t j = 0; j < i; j++) {
+                    f = d[j];
+                    g = e[j];
+
+                    for (size_t k = j; k < i; k++) {
+                        v[k * n + j] = v[k * n + j] - (f * e[k] + g * d[k]);
+                    }
+
+                    d[j] = v[(i - 1) * n + j];
+                    v[i * n + j] = T();
+                }
+            }
+
+            d[i] = h;
+        }
+
+        for (size_t i = 0; i + 1 < n; i++) {
+            v[(n - 1) * n + i] = v[i * n + i];
+            v[i * n + i] = T(1);
+            T h = d[i + 1];
+
+            if (h != T()) {
+                for (size_t k = 0; k <= i; k++) {
+                    d[k] = v[k * n + i + 1] / h;
+                }
+
+                for (size_t j = 0; j <= i; j++) {
+                    T g = T();
+
+                    for (size_t k = 0; k <= i; k++) {
+                        g = g + v[k * n + i + 1] * v[k * n + j];
+                    }
+
+                    for (size_t k = 0; k <= i; k++) {
+                        v[k * n + j] = v[k * n + j] - g * d[k];
+                    }
+                }
+            }
+
+            for (size_t k = 0; k <= i; k++) {
+                v[k * n + i + 1] = T();
+            }
+        }
+
+        for (size_t j = 0; j < n; j++) {
+            d[j] = v[(n - 1) * n + j];
+            v[(n - 1) * n + j] = T();
+        }
+
+        v[(n - 1) * n + n - 1] = T(1);
+
+        // The QL sweeps rotate pairs of eigenvector columns; work on the
+        // transpose so that those are contiguous rows.
+        vectors = matrix<T>(vectors.t());
+        v = vectors.data();
+
+        for (size_t i = 1; i < n; i++) {
+            e[i - 1] = e[i];
+        }
+
+        e[n - 1] = T();
+        T f = T();
+        T largest = T();
+        T eps = std::numeric_limits<T>::epsilon();
+
+        for (size_t l = 0; l < n; l++) {
+            largest = std::max(largest, std::abs(d[l]) + std::abs(e[l]));
+            size_t m = l;
+
+            while ((m + 1 < n) && (std::abs(e[m]) > eps * largest)) {
+                m++;
+            }
+
+            size_t iterations = 0;
+
+            while ((m > l) && (std::abs(e[l]) > eps * largest)) {
+#ifndef MATRIX_NOTHROW
+                if (iterations++ > 30 * n) {
+                    throw std::runtime_error(__error_messages[ERR_NO_CONVERGENCE]);
+                }
+#endif
+                T g = d[l];
+                T p = (d[l + 1] - g) / (T(2) * e[l]);
+                T r = std::hypot(p, T(1));
+                r = (p < T()) ? -r : r;
+                d[l] = e[l] / (p + r);
+                d[l + 1] = e[l] * (p + r);
+                T next = d[l + 1];
+                T h = g - d[l];
+
+                for (size_t i = l + 2; i < n; i++) {
+                    d[i] = d[i] - h;
+                }
+
+                f = f + h;
+                p = d[m];
+                T c = T(1);
+                T c2 = c;
+                T c3 = c;
+                T el1 = e[l + 1];
+                T s = T();
+                T s2 = T();
+
+                for (size_t i = m; i-- > l;) {
+                    c3 = c2;
+                    c2 = c;
+                    s2 = s;
+                    g = c * e[i];
+                    h = c * p;
+                    r = std::hypot(p, e[i]);
+                    e[i + 1] = s * r;
+                    s = e[i] / r;
+                    c = p / r;
+                    p = c * d[i] - s * g;
+                    d[i + 1] = h + s * (c * g + s * d[i]);
+
+                    for (size_t k = 0; k < n; k++) {
+                        h = v[(i + 1) * n + k];
+                        v[(i + 1) * n + k] = s * v[i * n + k] + c * h;
+                        v[i * n + k] = c * v[i * n + k] - s * h;
+                    }
+                }
+
+                p = -s * s2 * c3 * el1 * e[l] / next;
+                e[l] = s * p;
+                d[l] = c * p;
+            }
+
+            d[l] = d[l] + f;
+            e[l] = T();
+        }
+
+        for (size_t i = 0; i + 1 < n; i++) {
+            size_t k = i;
+
+            for (size_t j = i + 1; j < n; j++) {
+                if (d[j] < d[k]) {
+                    k = j;
+                }
+            }
+
+            if (k != i) {
+                std::swap(d[k], d[i]);
+
+                for (size_t j = 0; j < n; j++) {
+                    std::swap(v[i * n + j], v[k * n + j]);
+                }
+            }
+        }
+
+        vectors = matrix<T>(vectors.t());
+    }
+
+    // Rotation [c s; -conj(s) c] with real c taking (x, y) to (r, 0).
+    template<typename R>
+    void __givens(const std::complex<R>& x, const std::complex<R>& y, R& c, std::complex<R>& s) {
+        R ax = std::abs(x);
+        R r = std::hypot(ax, std::abs(y));
+
+        if (r == R()) {
+            c = R(1);
+            s = std::complex<R>();
+        } else if (ax == R()) {
+            c = R();
+            s = std::conj(y) / std::abs(y);
+        } else {
+            c = ax / r;
+            s = (x / ax) * std::conj(y) / r;
+        }
+    }
+
+    // Turns the column segment x held in v into the unit Householder vector
+    // of I - 2 v v^H, which maps x to a multiple of e1. False when x is zero.
+    template<typename R>
+    bool __reflector(std::vector<std::complex<R>>& v) {
+        using C = std::complex<R>;
+        R norm = R();
+
+        for (const C& x : v) {
+            norm = norm + std::norm(x);
+        }
+
+        norm = std::sqrt(norm);
+
+        if (norm == R()) {
+            return false;
+        }
+
+        C alpha = (std::abs(v[0]) == R()) ? C(-norm) : -v[0] / std::abs(v[0]) * norm;
+        v[0] = v[0] - alpha;
+        R length = R();
+
+        for (const C& x : v) {
+            length = length + std::norm(x);
+        }
+
+        length = std::sqrt(length);
+
+        for (C& x : v) {
+            x = x / length;
+        }
+
+        return true;
+    }
+
+    // m = (I - 2 v v^H) m on rows [offset, offset + v.size()), columns from
+    // `from` on.
+    template<typename R>
+    void __reflect_rows(matrix<std::complex<R>>& m, const std::vector<std::complex<R>>& v, size_t offset, size_t from) {
+        using C = std::complex<R>;
+
+        for (size_t column = from; column < m.columns(); column++) {
+            C sum = C();
+
+            for (size_t index = 0; index < v.size(); index++) {
+                sum = sum + std::conj(v[index]) * m(offset + index, column);
+            }
+
+            for (size_t index = 0; index < v.size(); index++) {
+                m(offset + index, column) = m(offset + index, column) - R(2) * v[index] * sum;
+            }
+        }
+    }
+
+    // m = m (I - 2 v v^H) on columns [offset, offset + v.size()).
+    template<typename R>
+    void __reflect_columns(matrix<std::complex<R>>& m, const std::vector<std::complex<R>>& v, size_t offset) {
+        using C = std::complex<R>;
+
+        for (size_t row = 0; row < m.rows(); row++) {
+            C sum = C();
+
+            for (size_t index = 0; index < v.size(); index++) {
+                sum = sum + m(row, offset + index) * v[index];
+            }
+
+            for (size_t index = 0; index < v.size(); index++) {
+                m(row, offset + index) = m(row, offset + index) - R(2) * sum * std::conj(v[index]);
+            }
+        }
+    }
+
+    // Eigenvectors of the upper triangular pencil (S, T), mapped back through
+    // the accumulated transformation z and normalized to unit length. For
+    // eigenvalue alpha / beta = S(k, k) / T(k, k), (beta S - alpha T) y = 0
+    // is solved by back-substitution with y(k) = 1; near-zero denominators
+    // are clamped to `small`. The standard problem passes T = I.
+    template<typename R>
+    matrix<std::complex<R>> __triangular_eigenvectors(const matrix<std::complex<R>>& s, const matrix<std::complex<R>>& t, const matrix<std::complex<R>>& z, R small) {
+        using C = std::complex<R>;
+        size_t n = s.rows();
+        matrix<C> result(n, n);
+
+        for (size_t k = 0; k < n; k++) {
+            C alpha = s(k, k);
+            C beta = t(k, k);
+            std::vector<C> y(k + 1);
+            y[k] = C(1);
+
+            for (size_t i = k; i-- > 0;) {
+                C sum = C();
+
+                for (size_t j = i + 1; j <= k; j++) {
+                    sum = sum + (beta * s(i, j) - alpha * t(i, j)) * y[j];
+                }
+
+                C denominator = beta * s(i, i) - alpha * t(i, i);
+
+                if (std::abs(denominator) < small) {
+                    denominator = C(small);
+                }
+
+                y[i] = -sum / denominator;
+            }
+
+            R length = R();
+
+            for (size_t row = 0; row < n; row++) {
+                C sum = C();
+
+                for (size_t j = 0; j <= k; j++) {
+                    sum = sum + z(row, j) * y[j];
+                }
+
+                result(row, k) = sum;
+                length = length + std::norm(sum);
+            }
+
+            length = std::sqrt(length);
+
+            for (size_t row = 0; row < n; row++) {
+                result(row, k) = result(row, k) / length;
+            }
+        }
+
+        return result;
+    }
+
+    // Eigenpairs of a small dense complex matrix: Householder reduction to
+    // Hessenberg form, single-shift QR with Wilkinson shifts down to the
+    // Schur form, then back-substitution for the eigenvectors.
+    template<typename R>
+    void __eigen(matrix<std::complex<R>> h, std::vector<std::complex<R>>& values, matrix<std::complex<R>>& vectors) {
+        using C = std::complex<R>;
+        size_t n = h.rows();
+        R eps = std::numeric_limits<R>::epsilon();
+        matrix<C> z(n, n);
+
+        for (size_t index = 0; index < n; index++) {
+            z(index, index) = C(1);
+        }
+
+        for (size_t k = 0; k + 2 < n; k++) {
+            std::vector<C> v(n - k - 1);
+
+            for (size_t index = 0; index < v.size(); index++) {
+                v[index] = h(k + 1 + index, k);
+            }
+
+            if (!__reflector(v)) {
+                continue;
+            }
+
+            __reflect_rows(h, v, k + 1, k);
+            __reflect_columns(h, v, k + 1);
+            __reflect_columns(z, v, k + 1);
+
+            for (size_t row = k + 2; row < n; row++) {
+                h(row, k) = C();
+            }
+        }
+
+        size_t hi = (n > 0) ? n - 1 : 0;
+        size_t iterations = 0;
+
+        while (hi > 0) {
+            size_t lo = hi;
+
+            while (lo > 0) {
+                R scale = std::abs(h(lo - 1, lo - 1)) + std::abs(h(lo, lo));
+
+                if (std::abs(h(lo, lo - 1)) <= eps * scale) {
+                    h(lo, lo - 1) = C();
+                    break;
+                }
+
+                lo--;
+            }
+
+            if (lo == hi) {
+                hi--;
+                iterations = 0;
+                continue;
+            }
+#ifndef MATRIX_NOTHROW
+            if (iterations > 30 * n) {
+                throw std::runtime_error(__error_messages[ERR_NO_CONVERGENCE]);
+            }
+#endif
+            iterations++;
+
+            C a = h(hi - 1, hi - 1);
+            C b = h(hi - 1, hi);
+            C c = h(hi, hi - 1);
+            C d = h(hi, hi);
+            C half = (a + d) / R(2);
+            C root = std::sqrt(half * half - (a * d - b * c));
+            C shift = (std::abs(half + root - d) < std::abs(half - root - d)) ? half + root : half - root;
+
+            if (iterations % 10 == 0) {
+                shift = d + std::abs(std::real(c)) + std::abs(std::imag(c));
+            }
+
+            C x = h(lo, lo) - shift;
+            C y = h(lo + 1, lo);
+
+            for (size_t j = lo; j < hi; j++) {
+                R cosine;
+                C sine;
+                __givens(x, y, cosine, sine);
+
+                for (size_t column = (j > lo) ? j - 1 : j; column < n; column++) {
+                    C u = h(j, column);
+                    C w = h(j + 1, column);
+                    h(j, column) = cosine * u + sine * w;
+                    h(j + 1, column) = -std::conj(sine) * u + cosine * w;
+                }
+
+                if (j > lo) {
+                    h(j + 1, j - 1) = C();
+                }
+
+                for (size_t row = 0; row <= std::min(j + 2, hi); row++) {
+                    C u = h(row, j);
+                    C w = h(row, j + 1);
+                    h(row, j) = u * cosine + w * std::conj(sine);
+                    h(row, j + 1) = -u * sine + w * cosine;
+                }
+
+                for (size_t row = 0; row < n; row++) {
+                    C u = z(row, j);
+                    C w = z(row, j + 1);
+                    z(row, j) = u * cosine + w * std::conj(sine);
+                    z(row, j + 1) = -u * sine + w * cosine;
+                }
+
+                if (j + 1 < hi) {
+                    x = h(j + 1, j);
+                    y = h(j + 2, j);
+                }
+            }
+        }
+
+        R norm = R();
+
+        for (size_t row = 0; row < n; row++) {
+            for (size_t column = row; column < n; column++) {
+                norm = std::max(norm, std::abs(h(row, column)));
+            }
+        }
+
+        R small = eps * std::max(norm, R(1));
+        matrix<C> identity(n, n);
+        values.resize(n);
+
+        for (size_t k = 0; k < n; k++) {
+            values[k] = h(k, k);
+            identity(k, k) = C(1);
+        }
+
+        vectors = __triangular_eigenvectors(h, identity, z, small);
+    }
+
+    // Indices of the Ritz values, most wanted first.
+    template<typename V>
+    std::vector<size_t> __select(const std::vector<V>& values, eigen_selection which) {
+        std::vector<size_t> result(values.size());
+        std::iota(result.begin(), result.end(), size_t(0));
+
+        auto key = [&](size_t index) {
+            switch (which) {
+            case eigen_selection::largest_magnitude:
+                return static_cast<double>(std::abs(values[index]));
+            case eigen_selection::smallest_magnitude:
+                return -static_cast<double>(std::abs(values[index]));
+            case eigen_selection::largest_real:
+                return static_cast<double>(std::real(values[index]));
+            default:
+                return -static_cast<double>(std::real(values[index]));
+            }
+        };
+
+        std::stable_sort(result.begin(), result.end(), [&](size_t x, size_t y) { return key(x) > key(y); });
+        return result;
+    }
+
+    // Orthonormal basis of the projected subspace kept across a restart. For
+    // symmetric problems these are the wanted Ritz vectors themselves; for
+    // general ones the real and imaginary parts are orthonormalized, which
+    // keeps complex conjugate pairs together and the basis real.
+    template<typename T>
+    matrix<T> __restart_basis(const matrix<T>& y, const std::vector<size_t>& order, size_t keep, size_t) {
+        matrix<T> result(y.rows(), keep);
+
+        for (size_t row = 0; row < y.rows(); row++) {
+            for (size_t column = 0; column < keep; column++) {
+                result(row, column) = y(row, order[column]);
+            }
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    matrix<T> __restart_basis(const matrix<std::complex<T>>& y, const std::vector<size_t>& order, size_t keep, size_t limit) {
+        size_t n = y.rows();
+        matrix<T> basis(n, limit);
+        std::vector<T> candidate(n);
+        size_t count = 0;
+
+        for (size_t index = 0; (index < order.size()) && (count < keep); index++) {
+            for (size_t part = 0; (part < 2) && (count < limit); part++) {
+                for (size_t row = 0; row < n; row++) {
+                    candidate[row] = (part == 0) ? std::real(y(row, order[index])) : std::imag(y(row, order[index]));
+                }
+
+                for (size_t pass = 0; pass < 2; pass++) {
+                    for (size_t column = 0; column < count; column++) {
+                        T dot = T();
+
+                        for (size_t row = 0; row < n; row++) {
+                            dot = dot + basis(row, column) * candidate[row];
+                        }
+
+                        for (size_t row = 0; row < n; row++) {
+                            candidate[row] = candidate[row] - dot * basis(row, column);
+                        }
+                    }
+                }
+
+                T length = T();
+
+                for (size_t row = 0; row < n; row++) {
+                    length = length + candidate[row] * candidate[row];
+                }
+
+                length = std::sqrt(length);
+
+                if (length > std::sqrt(std::numeric_limits<T>::epsilon())) {
+                    for (size_t row = 0; row < n; row++) {
+                        basis(row, count) = candidate[row] / length;
+                    }
+
+                    count++;
+                }
+            }
+        }
+
+        matrix<T> result(basis.block(0, 0, n, count));
+        return result;
+    }
+
+    // Orthogonalizes the block w against the first `width` basis columns
+    // (classical Gram-Schmidt, twice, through GEMM) and then within itself.
+    // Directions lost to breakdown are replaced by random ones with a zero
+    // coupling coefficient.
+    template<typename T>
+    void __orthogonalize(const matrix<T>& basis, size_t width, matrix<T>& w, matrix<T>& coefficients, matrix<T>& r, std::mt19937& random) {
+        size_t n = w.rows();
+        size_t b = w.columns();
+        std::vector<T> norms(b);
+        coefficients = matrix<T>(std::max<size_t>(width, 1), b);
+        r = matrix<T>(b, b);
+
+        for (size_t column = 0; column < b; column++) {
+            for (size_t row = 0; row < n; row++) {
+                norms[column] = norms[column] + w(row, column) * w(row, column);
+            }
+
+            norms[column] = std::sqrt(norms[column]);
+        }
+
+        auto project = [&](matrix<T>& block, matrix<T>* total) {
+            if (width == 0) {
+                return;
+            }
+
+            for (size_t pass = 0; pass < 2; pass++) {
+                matrix<T> c(width, block.columns());
+                gemm(T(1), basis.block(0, 0, n, width).t(), block.view(), T(), c.view());
+                gemm(T(-1), basis.block(0, 0, n, width), c.view(), T(1), block.view());
+
+                if (total != nullptr) {
+                    *total = *total + c;
+                }
+            }
+        };
+
+        project(w, (width > 0) ? &coefficients : nullptr);
+        std::normal_distribution<T> normal;
+
+        for (size_t column = 0; column < b; column++) {
+            for (size_t pass = 0; pass < 2; pass++) {
+                for (size_t previous = 0; previous < column; previous++) {
+                    T dot = T();
+
+                    for (size_t row = 0; row < n; row++) {
+                        dot = dot + w(row, previous) * w(row, column);
+                    }
+
+                    for (size_t row = 0; row < n; row++) {
+                        w(row, column) = w(row, column) - dot * w(row, previous);
+                    }
+
+                    r(previous, column) = r(previous, column) + dot;
+                }
+            }
+
+            T length = T();
+
+            for (size_t row = 0; row < n; row++) {
+                length = length + w(row, column) * w(row, column);
+            }
+
+            length = std::sqrt(length);
+
+            if (length > T(100) * std::numeric_limits<T>::epsilon() * norms[column]) {
+                r(column, column) = length;
+            } else {
+                matrix<T> fill(n, 1);
+
+                for (size_t row = 0; row < n; row++) {
+                    fill(row, 0) = normal(random);
+                }
+
+                project(fill, nullptr);
+
+                for (size_t pass = 0; pass < 2; pass++) {
+                    for (size_t previous = 0; previous < column; previous++) {
+                        T dot = T();
+
+                        for (size_t row = 0; row < n; row++) {
+                            dot = dot + w(row, previous) * fill(row, 0);
+                        }
+
+                        for (size_t row = 0; row < n; row++) {
+                            fill(row, 0) = fill(row, 0) - dot * w(row, previous);
+                        }
+                    }
+                }
+
+                length = __norm(fill);
+
+                for (size_t row = 0; row < n; row++) {
+                    w(row, column) = fill(row, 0);
+                }
+
+                r(column, column) = T();
+            }
+
+            for (size_t row = 0; row < n; row++) {
+                w(row, column) = w(row, column) / length;
+            }
+        }
+    }
+
+    template<typename TS, typename T>
+    void __copy_block(const matrix_view<TS>& source, const matrix_view<T>& target) {
+        for (size_t row = 0; row < source.rows(); row++) {
+            for (size_t column = 0; column < source.columns(); column++) {
+                target(row, column) = source(row, column);
+            }
+        }
+    }
+
+    template<typename TB, typename T>
+    matrix<T> __ritz_vectors(const matrix_view<TB>& basis, const matrix<T>& y) {
+        matrix<T> result(basis.rows(), y.columns());
+        gemm(T(1), basis, y.view(), T(), result.view());
+        return result;
+    }
+
+    template<typename TB, typename T>
+    matrix<std::complex<T>> __ritz_vectors(const matrix_view<TB>& basis, const matrix<std::complex<T>>& y) {
+        matrix<T> real(y.rows(), y.columns());
+        matrix<T> imaginary(y.rows(), y.columns());
+        real.transform([&](size_t row, size_t column, T& x) { x = std::real(y(row, column)); });
+        imaginary.transform([&](size_t row, size_t column, T& x) { x = std::imag(y(row, column)); });
+        matrix<T> x = __ritz_vectors(basis, real);
+        matrix<T> z = __ritz_vectors(basis, imaginary);
+        matrix<std::complex<T>> result(x.rows(), x.columns());
+        result.transform([&](size_t row, size_t column, std::complex<T>& value) { value = std::complex<T>(x(row, column), z(row, column)); });
+        return result;
+    }
+
+    // Block Krylov-Schur iteration. The basis V is expanded a block at a time
+    // while keeping A V = V H + V' R, with V' the next (residual) block. At a
+    // restart the wanted part of the spectrum of H is kept: V <- V Q for an
+    // orthonormal basis Q of the wanted Ritz vectors, H <- Q^T H Q and
+    // R <- R Q. This is the thick-restart form of implicit restarting with
+    // exact shifts, without the bulge chasing.
+    template<bool Symmetric, typename T, typename Operator>
+    auto __krylov_schur(const Operator& a, size_t n, size_t count, const eigen_options& options) {
+        static_assert(std::is_floating_point_v<T>, "Krylov eigensolvers need a real floating point type.");
+        using V = std::conditional_t<Symmetric, T, std::complex<T>>;
+        eigen_selection which = __is_shift_invert<Operator>::value ? eigen_selection::largest_magnitude : options.which;
+        size_t b = std::max<size_t>(options.block_size, 1);
+        size_t m = (options.subspace > 0) ? options.subspace : std::max<size_t>(2 * count, 20) + 8 * (b - 1);
+        m = std::min(std::max(m, count + b), n);
+#ifndef MATRIX_NOTHROW
+        if ((count == 0) || (count > n) || (b > n)) {
+            throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+        }
+#endif
+        std::mt19937 random(options.seed);
+        std::normal_distribution<T> normal;
+        matrix<T> basis(n, m + b);
+        matrix<T> projection(m + b, m);
+        matrix<T> coefficients;
+        matrix<T> r;
+        matrix<T> start(n, b);
+        start.transform([&](size_t, size_t, T& x) { x = normal(random); });
+        __orthogonalize(basis, 0, start, coefficients, r, random);
+        __copy_block(start.block(0, 0, n, b), basis.block(0, 0, n, b));
+
+        size_t j = 0;
+        size_t restarts = 0;
+
+        while (true) {
+            while (j + b <= m) {
+                matrix<T> x(basis.block(0, j, n, b));
+                matrix<T> w = __apply(a, x);
+                __orthogonalize(basis, j + b, w, coefficients, r, random);
+                __copy_block(coefficients.block(0, 0, j + b, b), projection.block(0, j, j + b, b));
+                __copy_block(r.block(0, 0, b, b), projection.block(j + b, j, b, b));
+                __copy_block(w.block(0, 0, n, b), basis.block(0, j + b, n, b));
+                j = j + b;
+            }
+
+            size_t size = j;
+            matrix<T> small(projection.block(0, 0, size, size));
+            matrix<T> coupling(projection.block(size, 0, b, size));
+            std::vector<V> theta;
+            matrix<V> y;
+
+            if constexpr (Symmetric) {
+                __symmetric_eigen(matrix<T>((small + small.t()) * T(0.5)), theta, y);
+            } else {
+                matrix<V> complex(size, size);
+                complex.transform([&](size_t row, size_t column, V& x) { x = V(small(row, column)); });
+                __eigen(complex, theta, y);
+            }
+
+            std::vector<size_t> order = __select(theta, which);
+            size_t converged = 0;
+
+            for (size_t index = 0; index < count; index++) {
+                T residual = T();
+
+                for (size_t row = 0; row < b; row++) {
+                    V sum = V();
+
+                    for (size_t column = 0; column < size; column++) {
+                        sum = sum + coupling(row, column) * y(column, order[index]);
+                    }
+
+                    residual = residual + std::norm(sum);
+                }
+
+                T scale = std::max<T>(std::abs(theta[order[index]]), std::pow(std::numeric_limits<T>::epsilon(), T(2) / T(3)));
+
+                if (std::sqrt(residual) <= T(options.tolerance) * scale) {
+                    converged++;
+                }
+            }
+
+            if ((converged == count) || (size == n) || (restarts >= options.max_restarts)) {
+                eigen_result<V> result;
+                matrix<V> wanted(size, count);
+                result.values = matrix<V>(count, 1);
+
+                for (size_t index = 0; index < count; index++) {
+                    result.values(index, 0) = theta[order[index]];
+
+                    if constexpr (__is_shift_invert<Operator>::value) {
+                        result.values(index, 0) = a.shift() + V(1) / theta[order[index]];
+                    }
+
+                    for (size_t row = 0; row < size; row++) {
+                        wanted(row, index) = y(row, order[index]);
+                    }
+                }
+
+                result.vectors = __ritz_vectors(basis.block(0, 0, n, size), wanted);
+                result.converged = (size == n) ? count : converged;
+                result.restarts = restarts;
+                result.iterations = 0;
+                return result;
+            }
+
+            size_t keep = std::min(count + (size - count) / 2, m - b);
+            matrix<T> q = __restart_basis(y, order, keep, m - b);
+            size_t k = q.columns();
+            matrix<T> kept(n, k);
+            gemm(T(1), basis.block(0, 0, n, size), q.view(), T(), kept.view());
+            matrix<T> residual(basis.block(0, size, n, b));
+            matrix<T> reduced = q.t() * (small * q);
+            matrix<T> reduced_coupling = coupling * q;
+
+            projection = matrix<T>(m + b, m);
+            __copy_block(kept.block(0, 0, n, k), basis.block(0, 0, n, k));
+            __copy_block(residual.block(0, 0, n, b), basis.block(0, k, n, b));
+            __copy_block(reduced.block(0, 0, k, k), projection.block(0, 0, k, k));
+            __copy_block(reduced_coupling.block(0, 0, b, k), projection.block(k, 0, b, k));
+            j = k;
+            restarts++;
+        }
+    }
+
+    // A few extreme eigenpairs of a real symmetric operator: a dense or
+    // sparse matrix, a shift_invert, or any callable mapping an n x b block
+    // to A times it. options.block_size > 1 applies the operator to blocks.
+    template<typename T, typename Operator>
+    eigen_result<T> lanczos(const Operator& a, size_t size, size_t count, const eigen_options& options = eigen_options()) {
+        eigen_result<T> result = __krylov_schur<true, T>(a, size, count, options);
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns>
+    eigen_result<T> lanczos(const matrix<T, Rows, Columns>& a, size_t count, const eigen_options& options = eigen_options()) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        eigen_result<T> result = __krylov_schur<true, T>(a, a.rows(), count, options);
+        return result;
+    }
+
+    template<typename T>
+    eigen_result<T> lanczos(const shift_invert<T>& a, size_t count, const eigen_options& options = eigen_options()) {
+        eigen_result<T> result = __krylov_schur<true, T>(a, a.rows(), count, options);
+        return result;
+    }
+
+    // The same for general real operators; Ritz pairs are complex.
+    template<typename T, typename Operator>
+    eigen_result<std::complex<T>> arnoldi(const Operator& a, size_t size, size_t count, const eigen_options& options = eigen_options()) {
+        eigen_result<std::complex<T>> result = __krylov_schur<false, T>(a, size, count, options);
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns>
+    eigen_result<std::complex<T>> arnoldi(const matrix<T, Rows, Columns>& a, size_t count, const eigen_options& options = eigen_options()) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        eigen_result<std::complex<T>> result = __krylov_schur<false, T>(a, a.rows(), count, options);
+        return result;
+    }
+
+    template<typename T>
+    eigen_result<std::complex<T>> arnoldi(const shift_invert<T>& a, size_t count, const eigen_options& options = eigen_options()) {
+        eigen_result<std::complex<T>> result = __krylov_schur<false, T>(a, a.rows(), count, options);
+        return result;
+    }
+
+    // A block of vectors together with A and B applied to it, so that the
+    // LOBPCG updates never reapply the operators to linear combinations.
+    template<typename T>
+    struct __lobpcg_block {
+        matrix<T> v;
+        matrix<T> av;
+        matrix<T> bv;
+    };
+
+    template<typename T>
+    matrix<T> __gram(const matrix<T>& x, const matrix<T>& y) {
+        matrix<T> result(x.columns(), y.columns());
+        gemm(T(1), x.view().t(), y.view(), T(), result.view());
+        return result;
+    }
+
+    // The columns [offset, offset + z.rows()) of a block times z, as one
+    // gemm per member on views of the selected columns.
+    template<typename T>
+    __lobpcg_block<T> __combine_block(const __lobpcg_block<T>& block, size_t offset, const matrix<T>& z) {
+        size_t n = block.v.rows();
+        __lobpcg_block<T> result = {matrix<T>(n, z.columns()), matrix<T>(n, z.columns()), matrix<T>(n, z.columns())};
+        gemm(T(1), block.v.block(0, offset, n, z.rows()), z.view(), T(), result.v.view());
+        gemm(T(1), block.av.block(0, offset, n, z.rows()), z.view(), T(), result.av.view());
+        gemm(T(1), block.bv.block(0, offset, n, z.rows()), z.view(), T(), result.bv.view());
+        return result;
+    }
+
+    // Removes the B-components along an already B-orthonormal block.
+    template<typename T>
+    void __project_block(__lobpcg_block<T>& block, const __lobpcg_block<T>& basis) {
+        if ((block.v.size() == 0) || (basis.v.size() == 0)) {
+            return;
+        }
+
+        matrix<T> c = __gram(basis.v, block.bv);
+        block.v = block.v - basis.v * c;
+        block.av = block.av - basis.av * c;
+        block.bv = block.bv - basis.bv * c;
+    }
+
+    // B-orthonormalizes a block through the eigendecomposition of its scaled
+    // Gram matrix (SVQB), dropping directions that are numerically dependent.
+    template<typename T>
+    void __orthonormalize_block(__lobpcg_block<T>& block) {
+        if (block.v.size() == 0) {
+            return;
+        }
+
+        size_t k = block.v.columns();
+        matrix<T> g = __gram(block.v, block.bv);
+        std::vector<T> scale(k);
+
+        for (size_t index = 0; index < k; index++) {
+            scale[index] = (g(index, index) > T()) ? T(1) / std::sqrt(g(index, index)) : T();
+        }
+
+        g = (g + g.t()) * T(0.5);
+        g.transform([&](size_t row, size_t column, T& x) { x = x * scale[row] * scale[column]; });
+        std::vector<T> theta;
+        matrix<T> y;
+        __symmetric_eigen(g, theta, y);
+        T threshold = std::sqrt(std::numeric_limits<T>::epsilon()) * std::max(theta.back(), T());
+        size_t dropped = 0;
+
+        while ((dropped < k) && (theta[dropped] <= threshold)) {
+            dropped++;
+        }
+
+        if (dropped == k) {
+            block = __lobpcg_block<T>();
+            return;
+        }
+
+        matrix<T> z(k, k - dropped);
+        z.transform([&](size_t row, size_t column, T& x) { x = scale[row] * y(row, column + dropped) / std::sqrt(theta[column + dropped]); });
+        block = __combine_block(block, 0, z);
+    }
+
+    // Stands in for B in the standard problem, where B x is x itself.
+    struct __identity_mass {};
+
+    // Locally optimal block preconditioned conjugate gradient for the extreme
+    // eigenpairs of A x = lambda B x, A symmetric and B symmetric positive
+    // definite. The columns of `initial` are the starting block, whose width
+    // is the number of eigenpairs computed. The smallest eigenvalues are
+    // targeted unless options.which is largest_real. Converged columns are
+    // soft-locked: they stay in the Rayleigh-Ritz basis but stop
+    // contributing residual and search directions.
+    template<typename T, typename OperatorA, typename OperatorB, typename Preconditioner = identity_preconditioner>
+    eigen_result<T> lobpcg(const OperatorA& a, const OperatorB& b, const matrix<T>& initial, const Preconditioner& preconditioner = Preconditioner(), const eigen_options& options = eigen_options()) {
+        static_assert(std::is_floating_point_v<T>, "LOBPCG needs a real floating point type.");
+        eigen_selection which = (options.which == eigen_selection::largest_real) ? eigen_selection::largest_real : eigen_selection::smallest_real;
+        size_t n = initial.rows();
+        size_t k = initial.columns();
+        auto mass = [&](const matrix<T>& x) {
+            if constexpr (std::is_same_v<OperatorB, __identity_mass>) {
+                return x;
+            } else {
+                return __apply(b, x);
+            }
+        };
+#ifndef MATRIX_NOTHROW
+        if ((k == 0) || (3 * k > n)) {
+            throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+        }
+#endif
+        __lobpcg_block<T> x = {initial, __apply(a, initial), mass(initial)};
+        __lobpcg_block<T> p;
+        __orthonormalize_block(x);
+#ifndef MATRIX_NOTHROW
+        if (x.v.size() == 0 || x.v.columns() != k) {
+            throw std::runtime_error(__error_messages[ERR_SINGULAR]);
+        }
+#endif
+        std::vector<T> lambda(k);
+        std::vector<bool> converged(k, false);
+        size_t iteration = 0;
+
+        while (true) {
+            // Rayleigh-Ritz on span [X, W, P], with W and P made B-orthonormal
+            // to X and to each other so that the projected problem is standard.
+            __lobpcg_block<T> w;
+            std::vector<size_t> active;
+
+            if (iteration > 0) {
+                for (size_t index = 0; index < k; index++) {
+                    if (!converged[index]) {
+                        active.push_back(index);
+                    }
+                }
+            }
+
+            if (!active.empty()) {
+                matrix<T> r(n, active.size());
+
+                for (size_t index = 0; index < active.size(); index++) {
+                    for (size_t row = 0; row < n; row++) {
+                        r(row, index) = x.av(row, active[index]) - lambda[active[index]] * x.bv(row, active[index]);
+                    }
+                }
+
+                w.v = preconditioner(r);
+                w.av = __apply(a, w.v);
+                w.bv = mass(w.v);
+
+                for (size_t pass = 0; pass < 2; pass++) {
+                    __project_block(w, x);
+                    __orthonormalize_block(w);
+                }
+
+                for (size_t pass = 0; pass < 2; pass++) {
+                    __project_block(p, x);
+                    __project_block(p, w);
+                    __orthonormalize_block(p);
+                }
+            }
+
+            size_t kw = w.v.columns();
+            size_t kp = p.v.columns();
+            size_t s = k + kw + kp;
+            __lobpcg_block<T> basis = {matrix<T>(n, s), matrix<T>(n, s), matrix<T>(n, s)};
+
+            auto place = [&](const __lobpcg_block<T>& block, size_t offset) {
+                size_t width = block.v.columns();
+
+                if (block.v.size() > 0) {
+                    __copy_block(block.v.block(0, 0, n, width), basis.v.block(0, offset, n, width));
+                    __copy_block(block.av.block(0, 0, n, width), basis.av.block(0, offset, n, width));
+                    __copy_block(block.bv.block(0, 0, n, width), basis.bv.block(0, offset, n, width));
+                }
+            };
+
+            place(x, 0);
+            place(w, k);
+            place(p, k + kw);
+
+            matrix<T> projected = __gram(basis.v, basis.av);
+            projected = (projected + projected.t()) * T(0.5);
+            std::vector<T> theta;
+            matrix<T> y;
+            __symmetric_eigen(projected, theta, y);
+            std::vector<size_t> order = __select(theta, which);
+            matrix<T> c(s, k);
+
+            for (size_t index = 0; index < k; index++) {
+                lambda[index] = theta[order[index]];
+
+                for (size_t row = 0; row < s; row++) {
+                    c(row, index) = y(row, order[index]);
+                }
+            }
+
+            if (s > k) {
+                p = __combine_block(basis, k, matrix<T>(c.block(k, 0, s - k, k)));
+            }
+
+            x = __combine_block(basis, 0, c);
+            iteration++;
+
+            size_t count = 0;
+
+            for (size_t index = 0; index < k; index++) {
+                T residual = T();
+
+                for (size_t row = 0; row < n; row++) {
+                    T value = x.av(row, index) - lambda[index] * x.bv(row, index);
+                    residual = residual + value * value;
+                }
+
+                T scale = std::max<T>(std::abs(lambda[index]), std::pow(std::numeric_limits<T>::epsilon(), T(2) / T(3)));
+                converged[index] = std::sqrt(residual) <= T(options.tolerance) * scale;
+                count = count + (converged[index] ? 1 : 0);
+            }
+
+            if ((count == k) || (iteration >= options.max_iterations)) {
+                eigen_result<T> result;
+                result.values = matrix<T>(k, 1);
+
+                for (size_t index = 0; index < k; index++) {
+                    result.values(index, 0) = lambda[index];
+                }
+
+                result.vectors = std::move(x.v);
+                result.converged = count;
+                result.restarts = 0;
+                result.iterations = iteration;
+                return result;
+            }
+        }
+    }
+
+    template<typename T, typename OperatorA, typename Preconditioner = identity_preconditioner, std::enable_if_t<std::is_invocable_v<const Preconditioner&, const matrix<T>&>, int> = 0>
+    eigen_result<T> lobpcg(const OperatorA& a, const matrix<T>& initial, const Preconditioner& preconditioner = Preconditioner(), const eigen_options& options = eigen_options()) {
+        eigen_result<T> result = lobpcg(a, __identity_mass(), initial, preconditioner, options);
+        return result;
+    }
+
+    // A x = lambda B x for symmetric A and symmetric positive definite B.
+    // With B = L L^T the pencil reduces to the standard problem
+    // C = L^-1 A L^-T; its eigenvectors map back as x = L^-T z, which makes
+    // them B-orthonormal. Values are ascending.
+    template<typename T, size_t RA, size_t CA, size_t RB, size_t CB>
+    eigen_result<T> generalized_symmetric_eigen(const matrix<T, RA, CA>& a, const matrix<T, RB, CB>& b) {
+        static_assert(std::is_floating_point_v<T>, "symmetric eigensolvers need a real floating point type.");
+#ifndef MATRIX_NOTHROW
+        if ((a.rows() != a.columns()) || (b.rows() != b.columns())) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+
+        if (a.rows() != b.rows()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t n = a.rows();
+        cholesky_factorization<T> factorization = cholesky(b);
+        const matrix<T>& l = factorization.factor();
+        matrix<T> c(a);
+        __solve_lower(l.view(), false, c);
+        c = matrix<T>(c.t());
+        __solve_lower(l.view(), false, c);
+        c = (c + c.t()) * T(0.5);
+
+        std::vector<T> theta;
+        matrix<T> z;
+        __symmetric_eigen(c, theta, z);
+        __solve_upper(l.t(), false, z);
+
+        eigen_result<T> result;
+        result.values = matrix<T>(n, 1);
+
+        for (size_t index = 0; index < n; index++) {
+            result.values(index, 0) = theta[index];
+        }
+
+        result.vectors = std::move(z);
+        result.converged = n;
+        result.restarts = 0;
+        result.iterations = 0;
+        return result;
+    }
+
+    // A x = lambda B x for a general square pencil by complex single-shift
+    // QZ: B is triangularized by Householder QR, A is brought to Hessenberg
+    // form with Givens rotations that keep B triangular, and Wilkinson-shifted
+    // QZ sweeps drive A to triangular form. Eigenvalues are A(k, k) / B(k, k),
+    // infinite where B is singular; eigenvectors are normalized to unit
+    // length. iterations counts the QZ sweeps.
+    template<typename T, size_t RA, size_t CA, size_t RB, size_t CB>
+    auto generalized_eigen(const matrix<T, RA, CA>& a, const matrix<T, RB, CB>& b) {
+        using R = decltype(std::abs(std::declval<T>()));
+        using C = std::complex<R>;
+#ifndef MATRIX_NOTHROW
+        if ((a.rows() != a.columns()) || (b.rows() != b.columns())) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+
+        if (a.rows() != b.rows()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t n = a.rows();
+        R eps = std::numeric_limits<R>::epsilon();
+        matrix<C> s(n, n);
+        matrix<C> t(n, n);
+        matrix<C> z(n, n);
+        s.transform([&](size_t row, size_t column, C& x) { x = C(a(row, column)); });
+        t.transform([&](size_t row, size_t column, C& x) { x = C(b(row, column)); });
+
+        for (size_t index = 0; index < n; index++) {
+            z(index, index) = C(1);
+        }
+
+        // Left rotation on rows j, j + 1 of both matrices from column `from`.
+        auto rotate_rows = [&](size_t j, size_t from, R c, C sine) {
+            for (size_t column = from; column < n; column++) {
+                C u = s(j, column);
+                C w = s(j + 1, column);
+                s(j, column) = c * u + sine * w;
+                s(j + 1, column) = -std::conj(sine) * u + c * w;
+                u = t(j, column);
+                w = t(j + 1, column);
+                t(j, column) = c * u + sine * w;
+                t(j + 1, column) = -std::conj(sine) * u + c * w;
+            }
+        };
+
+        // Right rotation on columns j, j + 1, applied to rows 0..to of A.
+        auto rotate_columns = [&](size_t j, size_t to, R c, C sine) {
+            for (size_t row = 0; row < n; row++) {
+                if (row <= to) {
+                    C u = s(row, j);
+                    C w = s(row, j + 1);
+                    s(row, j) = c * u - std::conj(sine) * w;
+                    s(row, j + 1) = sine * u + c * w;
+                }
+
+                if (row <= j + 1) {
+                    C u = t(row, j);
+                    C w = t(row, j + 1);
+                    t(row, j) = c * u - std::conj(sine) * w;
+                    t(row, j + 1) = sine * u + c * w;
+                }
+
+                C u = z(row, j);
+                C w = z(row, j + 1);
+                z(row, j) = c * u - std::conj(sine) * w;
+                z(row, j + 1) = sine * u + c * w;
+            }
+        };
+
+        // The right rotation that restores B to triangular form after a
+        // left rotation on rows j, j + 1.
+        auto restore = [&](size_t j, size_t to) {
+            R c;
+            C sine;
+            __givens(t(j + 1, j + 1), t(j + 1, j), c, sine);
+            rotate_columns(j, to, c, sine);
+            t(j + 1, j) = C();
+        };
+
+        for (size_t k = 0; k + 1 < n; k++) {
+            std::vector<C> v(n - k);
+
+            for (size_t index = 0; index < v.size(); index++) {
+                v[index] = t(k + index, k);
+            }
+
+            if (!__reflector(v)) {
+                continue;
+            }
+
+            __reflect_rows(t, v, k, k);
+            __reflect_rows(s, v, k, 0);
+
+            for (size_t row = k + 1; row < n; row++) {
+                t(row, k) = C();
+            }
+        }
+
+        for (size_t column = 0; column + 2 < n; column++) {
+            for (size_t row = n - 1; row > column + 1; row--) {
+                R c;
+                C sine;
+                __givens(s(row - 1, column), s(row, column), c, sine);
+                rotate_rows(row - 1, column, c, sine);
+                s(row, column) = C();
+                restore(row - 1, n - 1);
+            }
+        }
+
+        R norm_t = R();
+
+        for (size_t row = 0; row < n; row++) {
+            for (size_t column = row; column < n; column++) {
+                norm_t = std::max(norm_t, std::abs(t(row, column)));
+            }
+        }
+
+        size_t hi = (n > 0) ? n - 1 : 0;
+        size_t iterations = 0;
+        size_t sweeps = 0;
+
+        while (hi > 0) {
+            size_t lo = hi;
+
+            while (lo > 0) {
+                R scale = std::abs(s(lo - 1, lo - 1)) + std::abs(s(lo, lo));
+
+                if (std::abs(s(lo, lo - 1)) <= eps * scale) {
+                    s(lo, lo - 1) = C();
+                    break;
+                }
+
+                lo--;
+            }
+
+            if (lo == hi) {
+                hi--;
+                iterations = 0;
+                continue;
+            }
+
+            // A zero on the diagonal of B at either end of the active block
+            // is an infinite eigenvalue; one rotation splits it off.
+            if (std::abs(t(hi, hi)) <= eps * norm_t) {
+                R c;
+                C sine;
+                t(hi, hi) = C();
+                __givens(s(hi, hi), s(hi, hi - 1), c, sine);
+                rotate_columns(hi - 1, hi, c, sine);
+                s(hi, hi - 1) = C();
+                continue;
+            }
+
+            if (std::abs(t(lo, lo)) <= eps * norm_t) {
+                t(lo, lo) = C();
+                R c;
+                C sine;
+                __givens(s(lo, lo), s(lo + 1, lo), c, sine);
+                rotate_rows(lo, lo, c, sine);
+                s(lo + 1, lo) = C();
+                continue;
+            }
+#ifndef MATRIX_NOTHROW
+            if (iterations > 30 * n) {
+                throw std::runtime_error(__error_messages[ERR_NO_CONVERGENCE]);
+            }
+#endif
+            iterations++;
+            sweeps++;
+
+            // Wilkinson shift from the trailing 2 x 2 of B^-1 A.
+            C b11 = t(hi - 1, hi - 1);
+            C b12 = t(hi - 1, hi);
+            C b22 = t(hi, hi);
+            C m11 = (s(hi - 1, hi - 1) - b12 * s(hi, hi - 1) / b22) / ((b11 == C()) ? C(1) : b11);
+            C m12 = (s(hi - 1, hi) - b12 * s(hi, hi) / b22) / ((b11 == C()) ? C(1) : b11);
+            C m21 = s(hi, hi - 1) / b22;
+            C m22 = s(hi, hi) / b22;
+            C half = (m11 + m22) / R(2);
+            C root = std::sqrt(half * half - (m11 * m22 - m12 * m21));
+            C shift = (std::abs(half + root - m22) < std::abs(half - root - m22)) ? half + root : half - root;
+
+            if ((iterations % 10 == 0) || (std::abs(b11) <= eps * norm_t)) {
+                shift = m22 + std::abs(m21);
+            }
+
+            C x = s(lo, lo) - shift * t(lo, lo);
+            C y = s(lo + 1, lo);
+
+            for (size_t j = lo; j < hi; j++) {
+                R c;
+                C sine;
+                __givens(x, y, c, sine);
+                rotate_rows(j, (j > lo) ? j - 1 : j, c, sine);
+
+                if (j > lo) {
+                    s(j + 1, j - 1) = C();
+                }
+
+                restore(j, std::min(j + 2, hi));
+
+                if (j + 1 < hi) {
+                    x = s(j + 1, j);
+                    y = s(j + 2, j);
+                }
+            }
+        }
+
+        eigen_result<C> result;
+        result.values = matrix<C>(n, 1);
+
+        for (size_t k = 0; k < n; k++) {
+            result.values(k, 0) = (t(k, k) == C()) ? C(std::numeric_limits<R>::infinity()) : s(k, k) / t(k, k);
+        }
+
+        result.vectors = __triangular_eigenvectors(s, t, z, eps * std::max<R>(norm_t, R(1)));
+        result.converged = n;
+        result.restarts = 0;
+        result.iterations = sweeps;
+        return result;
+    }
+}
+
+#endif
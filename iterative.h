@@ -0,0 +1,199 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_ITERATIVE_H
+#define MATRIX_ITERATIVE_H
+
+#include "matrix.h"
+
+namespace matrix {
+    template<typename T>
+    struct __is_matrix : std::false_type {};
+
+    template<typename T, size_t Rows, size_t Columns>
+    struct __is_matrix<matrix<T, Rows, Columns>> : std::true_type {};
+
+    // Linear operators are anything that maps a block of column vectors to
+    // another: a callable taking const matrix<T>&, or any type with a
+    // matrix product (dense matrices, sparse matrices).
+    template<typename T, typename Operator>
+    matrix<T> __apply(const Operator& a, const matrix<T>& x) {
+        if constexpr (std::is_invocable_v<const Operator&, const matrix<T>&>) {
+            matrix<T> result = a(x);
+            return result;
+        } else {
+            matrix<T> result = a * x;
+            return result;
+        }
+    }
+
+    template<typename T>
+    T __dot(const matrix<T>& x, const matrix<T>& y) {
+        T result = T();
+
+        for (size_t index = 0; index < x.size(); index++) {
+            result = result + __conjugate(x.data()[index]) * y.data()[index];
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    auto __norm(const matrix<T>& x) {
+        auto result = std::sqrt(std::real(__dot(x, x)));
+        return result;
+    }
+
+    // y = y + alpha * x
+    template<typename T>
+    void __axpy(T alpha, const matrix<T>& x, matrix<T>& y) {
+        for (size_t index = 0; index < x.size(); index++) {
+            y.data()[index] = y.data()[index] + alpha * x.data()[index];
+        }
+    }
+
+    // Preconditioners map a residual block r to an approximation of A^-1 r.
+    struct identity_preconditioner {
+        template<typename T>
+        matrix<T> operator()(const matrix<T>& residual) const {
+            matrix<T> result = residual;
+            return result;
+        }
+    };
+
+    template<typename T>
+    class jacobi_preconditioner {
+    private:
+        std::vector<T> m_inverse_diagonal;
+
+    public:
+        template<size_t Rows, size_t Columns>
+        jacobi_preconditioner(const matrix<T, Rows, Columns>& a) {
+            for (size_t index = 0; index < std::min(a.rows(), a.columns()); index++) {
+                m_inverse_diagonal.push_back(T(1) / a(index, index));
+            }
+        }
+
+        matrix<T> operator()(const matrix<T>& residual) const {
+            matrix<T> result = residual;
+
+            for (size_t row = 0; row < result.rows(); row++) {
+                for (size_t column = 0; column < result.columns(); column++) {
+                    result(row, column) = result(row, column) * m_inverse_diagonal[row];
+                }
+            }
+
+            return result;
+        }
+    };
+
+    struct iterative_options {
+        size_t max_iterations = 1000;
+        double tolerance = 1e-10;
+        const checkpoint* state = nullptr;
+    };
+
+    template<typename T>
+    struct iterative_result {
+        matrix<T> solution;
+        size_t iterations;
+        double residual;
+        bool converged;
+    };
+
+    // Preconditioned conjugate gradient for Hermitian positive definite A.
+    // With options.state set, the iterate, residual, search direction and
+    // recurrence scalar are snapshotted periodically and picked up again on
+    // the next call; the snapshot is removed when the solve returns.
+    template<typename T, typename Operator, typename Preconditioner = identity_preconditioner>
+    iterative_result<T> conjugate_gradient(const Operator& a, const matrix<T>& b, const Preconditioner& preconditioner = Preconditioner(), const iterative_options& options = iterative_options()) {
+        matrix<T> x(b.rows(), b.columns());
+        matrix<T> r = b;
+        matrix<T> p = preconditioner(r);
+        T rz = __dot(r, p);
+        size_t iteration = 0;
+        double norm_b = static_cast<double>(__norm(b));
+        double residual = (norm_b > 0) ? 1.0 : 0.0;
+        bool converged = (norm_b == 0);
+
+        if (options.state != nullptr) {
+            options.state->restore([&](std::istream& stream) {
+                iteration = __read_index(stream);
+                x = read_binary<T>(stream);
+                r = read_binary<T>(stream);
+                p = read_binary<T>(stream);
+                matrix<T> scalar = read_binary<T>(stream);
+#ifndef MATRIX_NOTHROW
+                if ((x.rows() != b.rows()) || (x.columns() != b.columns()) || (r.size() != b.size()) || (p.size() != b.size()) || (scalar.size() != 1)) {
+                    throw std::runtime_error(__error_messages[ERR_CHECKPOINT]);
+                }
+#endif
+                rz = scalar(0, 0);
+                residual = static_cast<double>(__norm(r)) / norm_b;
+            });
+        }
+
+        while (!converged && (iteration < options.max_iterations)) {
+            matrix<T> q = __apply(a, p);
+            T alpha = rz / __dot(p, q);
+            __axpy(alpha, p, x);
+            __axpy(-alpha, q, r);
+            iteration++;
+            residual = static_cast<double>(__norm(r)) / norm_b;
+
+            if (residual <= options.tolerance) {
+                converged = true;
+                break;
+            }
+
+            matrix<T> z = preconditioner(r);
+            T rz_next = __dot(r, z);
+            T beta = rz_next / rz;
+            rz = rz_next;
+
+            for (size_t index = 0; index < p.size(); index++) {
+                p.data()[index] = z.data()[index] + beta * p.data()[index];
+            }
+
+            if ((options.state != nullptr) && options.state->due(iteration)) {
+                options.state->save([&](std::ostream& stream) {
+                    matrix<T, 1, 1> scalar = {rz};
+                    __write_index(stream, iteration);
+                    write_binary(stream, x);
+                    write_binary(stream, r);
+                    write_binary(stream, p);
+                    write_binary(stream, scalar);
+                });
+            }
+        }
+
+        if (options.state != nullptr) {
+            options.state->clear();
+        }
+
+        iterative_result<T> result = {std::move(x), iteration, residual, converged};
+        return result;
+    }
+}
+
+#endif
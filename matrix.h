@@ -23,10 +23,54 @@ SOFTWARE.
 #ifndef MATRIX_H
 #define MATRIX_H
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
 #include <vector>
 
+#if defined(MATRIX_USE_CBLAS)
+#include <cblas.h>
+#endif
+
+#if defined(MATRIX_USE_LAPACKE)
+#include <lapacke.h>
+#endif
+
+#if defined(MATRIX_BLAS_DLOPEN)
+#include <cstdlib>
+#include <dlfcn.h>
+#endif
+
+#ifndef MATRIX_BLAS_THRESHOLD
+#define MATRIX_BLAS_THRESHOLD 64
+#endif
+
+#if (__cplusplus >= 202002L) && __has_include(<span>)
+#include <span>
+#endif
+
+#if (__cplusplus > 202002L) && __has_include(<mdspan>)
+#include <mdspan>
+#endif
+
+// std::mdspan interop. A compatible polyfill (e.g. the Kokkos reference
+// implementation) can be used by defining MATRIX_MDSPAN_NAMESPACE to its
+// namespace before including this header.
+#if !defined(MATRIX_MDSPAN_NAMESPACE) && defined(__cpp_lib_mdspan)
+#define MATRIX_MDSPAN_NAMESPACE std
+#endif
+
 namespace matrix {
 #ifndef MATRIX_NOTHROW
     enum __error_code {
@@ -34,7 +78,20 @@ namespace matrix {
         ERR_COL_RANGE,
         ERR_INVALID_SIZE,
         ERR_INCOMPATIBLE,
-        ERR_NOT_SQUARE
+        ERR_NOT_SQUARE,
+        ERR_STATIC_EXTENT,
+        ERR_SINGULAR,
+        ERR_NOT_POSITIVE_DEFINITE,
+        ERR_TRANSPORT,
+        ERR_PROCESS_GRID,
+        ERR_IO,
+        ERR_FORMAT,
+        ERR_CHECKPOINT,
+        ERR_NO_CONVERGENCE,
+        ERR_INDEX_RANGE,
+        ERR_SUBSCRIPTS,
+        ERR_SPARSE_FORMAT,
+        ERR_PERMUTATION
     };
 
     const char __error_messages[][53] = {
@@ -42,247 +99,2498 @@ namespace matrix {
         [ERR_COL_RANGE] = "column index out of range [0, columns - 1].",
         [ERR_INVALID_SIZE] = "invalid matrix dimensions [rows < 1 OR columns < 1].",
         [ERR_INCOMPATIBLE] = "incompatible matrix dimensions.",
-        [ERR_NOT_SQUARE] = "matrix must be square [rows = columns]."
+        [ERR_NOT_SQUARE] = "matrix must be square [rows = columns].",
+        [ERR_STATIC_EXTENT] = "dimensions do not match the static matrix extents.",
+        [ERR_SINGULAR] = "matrix is singular.",
+        [ERR_NOT_POSITIVE_DEFINITE] = "matrix is not positive definite.",
+        [ERR_TRANSPORT] = "transport failure.",
+        [ERR_PROCESS_GRID] = "process grid does not match the transport size.",
+        [ERR_IO] = "matrix input/output failed.",
+        [ERR_FORMAT] = "invalid binary matrix data.",
+        [ERR_CHECKPOINT] = "checkpoint does not match the problem.",
+        [ERR_NO_CONVERGENCE] = "iteration did not converge.",
+        [ERR_INDEX_RANGE] = "tensor index out of range.",
+        [ERR_SUBSCRIPTS] = "invalid einsum subscripts.",
+        [ERR_SPARSE_FORMAT] = "invalid sparse matrix structure.",
+        [ERR_PERMUTATION] = "invalid permutation."
     };
 #endif
 
-    template<typename T> 
-    class matrix {
+    template<typename T>
+    struct __is_complex : std::false_type {};
+
+    template<typename T>
+    struct __is_complex<std::complex<T>> : std::true_type {};
+
+    template<typename T>
+    T __conjugate(const T& value) {
+        if constexpr (__is_complex<T>::value) {
+            return std::conj(value);
+        } else {
+            return value;
+        }
+    }
+
+    constexpr size_t dyn = static_cast<size_t>(-1);
+
+    constexpr size_t __common_extent(size_t left, size_t right) {
+        return (left == dyn) ? right : left;
+    }
+
+    constexpr bool __compatible_extent(size_t left, size_t right) {
+        return (left == dyn) || (right == dyn) || (left == right);
+    }
+
+    constexpr bool __widening_extent(size_t to, size_t from) {
+        return (to == dyn) || (to == from);
+    }
+
+    constexpr size_t __reduce_extent(size_t extent) {
+        return (extent == dyn) ? dyn : extent - 1;
+    }
+
+    template<typename T, size_t Rows = dyn, size_t Columns = dyn>
+    class matrix;
+
+    // Non-owning strided window over matrix storage. Transposition swaps the
+    // strides and conjugation is applied on read, so neither copies anything.
+    template<typename T, bool Conjugate = false>
+    class matrix_view {
     private:
+        T* m_data;
         size_t m_rows;
         size_t m_columns;
-        std::vector<T> m_data;
+        size_t m_row_stride;
+        size_t m_column_stride;
 
     public:
-        matrix(size_t rows, size_t columns, T fill = T()) {
-#ifndef MATRIX_NOTHROW
-            if ((rows < 1) || (columns < 1)) {
-                throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
-            }
-#endif
+        using value_type = std::remove_const_t<T>;
+        using reference = std::conditional_t<Conjugate, value_type, T&>;
+
+        matrix_view(T* data, size_t rows, size_t columns, size_t row_stride, size_t column_stride) {
+            m_data = data;
             m_rows = rows;
             m_columns = columns;
-            m_data.resize(rows * columns);
+            m_row_stride = row_stride;
+            m_column_stride = column_stride;
+        }
 
-            for (size_t index = 0; index < rows * columns; index++) {
-                m_data.data()[index] = fill;
+        template<typename U, typename = std::enable_if_t<std::is_same_v<const U, T>>>
+        matrix_view(const matrix_view<U, Conjugate>& other)
+            : matrix_view(other.data(), other.rows(), other.columns(), other.row_stride(), other.column_stride()) {
+
+        }
+
+#ifdef __cpp_lib_span
+        matrix_view(std::span<T> data, size_t rows, size_t columns) : matrix_view(data.data(), rows, columns, columns, 1) {
+#ifndef MATRIX_NOTHROW
+            if (rows * columns != data.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
             }
+#endif
         }
+#endif
 
-        ~matrix() {
+#ifdef MATRIX_MDSPAN_NAMESPACE
+        template<typename Extents, typename Layout, typename Accessor>
+        matrix_view(const MATRIX_MDSPAN_NAMESPACE::mdspan<T, Extents, Layout, Accessor>& other)
+            : matrix_view(other.data_handle(), other.extent(0), other.extent(1), other.stride(0), other.stride(1)) {
+            static_assert(Extents::rank() == 2, "mdspan must have rank 2.");
+        }
 
+        auto to_mdspan() const {
+            static_assert(!Conjugate, "conjugated views have no mdspan equivalent.");
+            using extents_type = MATRIX_MDSPAN_NAMESPACE::dextents<size_t, 2>;
+            using mapping_type = typename MATRIX_MDSPAN_NAMESPACE::layout_stride::template mapping<extents_type>;
+            std::array<size_t, 2> strides = {m_row_stride, m_column_stride};
+            MATRIX_MDSPAN_NAMESPACE::mdspan<T, extents_type, MATRIX_MDSPAN_NAMESPACE::layout_stride> result(m_data, mapping_type(extents_type(m_rows, m_columns), strides));
+            return result;
         }
+#endif
 
-        size_t rows() {
+        size_t rows() const {
             size_t result = m_rows;
             return result;
         }
 
-        size_t columns() {
+        size_t columns() const {
             size_t result = m_columns;
             return result;
         }
 
-        matrix<T> row_vector(size_t row) {
-#ifndef MATRIX_NOTHROW
-            if ((row < 0) || (row >= m_rows)) {
-                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
-            }
-#endif
-            matrix<T> result(1, m_columns);
+        size_t row_stride() const {
+            size_t result = m_row_stride;
+            return result;
+        }
 
-            for (size_t column = 0; column < m_columns; column++) {
-                result(0, column) = (*this)(row, column);
-            }
+        size_t column_stride() const {
+            size_t result = m_column_stride;
+            return result;
+        }
 
+        T* data() const {
+            T* result = m_data;
             return result;
         }
 
-        matrix<T> column_vector(size_t column) {
+        reference operator()(size_t row, size_t column) const {
 #ifndef MATRIX_NOTHROW
-            if ((column < 0) || (column >= m_columns)) {
+            if (row >= m_rows) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+
+            if (column >= m_columns) {
                 throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
             }
 #endif
-            matrix<T> result(m_columns, 1);
-
-            for (size_t row = 0; row < m_rows; row++) {
-                result(row, 0) = (*this)(row, column);
+            if constexpr (Conjugate) {
+                value_type result = __conjugate(m_data[row * m_row_stride + column * m_column_stride]);
+                return result;
+            } else {
+                T& result = m_data[row * m_row_stride + column * m_column_stride];
+                return result;
             }
+        }
 
+        matrix_view<T, Conjugate> t() const {
+            matrix_view<T, Conjugate> result(m_data, m_columns, m_rows, m_column_stride, m_row_stride);
             return result;
         }
 
-        template <typename L>
-        matrix<T>& transform(L&& lambda) {
-            matrix<T>& result = (*this);
-
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    lambda(row, column, result(row, column));
-                }
-            }
+        matrix_view<T, !Conjugate> conj() const {
+            matrix_view<T, !Conjugate> result(m_data, m_rows, m_columns, m_row_stride, m_column_stride);
+            return result;
+        }
 
+        matrix_view<T, !Conjugate> h() const {
+            matrix_view<T, !Conjugate> result(m_data, m_columns, m_rows, m_column_stride, m_row_stride);
             return result;
         }
 
-        T& operator()(size_t row, size_t column) {
+        matrix_view<T, Conjugate> block(size_t row, size_t column, size_t rows, size_t columns) const {
 #ifndef MATRIX_NOTHROW
-            if ((row < 0) || (row >= m_rows)) {
+            if (row + rows > m_rows) {
                 throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
             }
 
-            if ((column < 0) || (column >= m_columns)) {
+            if (column + columns > m_columns) {
                 throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
             }
 #endif
-            T& result = m_data[row * m_columns + column];
+            matrix_view<T, Conjugate> result(m_data + row * m_row_stride + column * m_column_stride, rows, columns, m_row_stride, m_column_stride);
             return result;
         }
 
-        matrix<T>& operator=(std::initializer_list<T> operand) {
+        // The same elements, read row by row, as rows x columns. Needs
+        // contiguous row-major data: a whole matrix or full-width rows.
+        matrix_view<T, Conjugate> reshape(size_t rows, size_t columns) const {
 #ifndef MATRIX_NOTHROW
-            if (m_rows * m_columns != operand.size()) {
+            bool contiguous = ((m_columns <= 1) || (m_column_stride == 1)) && ((m_rows <= 1) || (m_row_stride == m_columns));
+
+            if ((rows * columns != m_rows * m_columns) || !contiguous) {
                 throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
             }
 #endif
-            matrix<T>& result = (*this);
-            result.m_data = operand;
+            matrix_view<T, Conjugate> result(m_data, rows, columns, columns, 1);
             return result;
         }
+    };
 
-        matrix<T> operator+(matrix<T>& operand) {
-#ifndef MATRIX_NOTHROW            
-            if ((m_rows != operand.m_rows) || (m_columns != operand.m_columns)) {
-                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+    template<typename T>
+    struct __is_view : std::false_type {};
+
+    template<typename T, bool Conjugate>
+    struct __is_view<matrix_view<T, Conjugate>> : std::true_type {};
+
+    template<typename T, bool Conjugate>
+    auto __element(const matrix_view<T, Conjugate>& view, size_t row, size_t column) {
+        std::remove_const_t<T> result = view.data()[row * view.row_stride() + column * view.column_stride()];
+
+        if constexpr (Conjugate) {
+            result = __conjugate(result);
+        }
+
+        return result;
+    }
+
+    // Optional system BLAS/LAPACK. MATRIX_USE_CBLAS / MATRIX_USE_LAPACKE bind
+    // the routines at link time; MATRIX_BLAS_DLOPEN looks them up at runtime
+    // (library from $MATRIX_BLAS_LIBRARY, else the usual OpenBLAS/BLIS names).
+    // Only float and double above blas_threshold are dispatched; everything
+    // else, or a missing library, stays on the native kernels.
+    inline size_t blas_threshold = MATRIX_BLAS_THRESHOLD;
+
+    template<typename T>
+    struct __blas_routines {
+        using gemm_type = void (*)(int, int, int, int, int, int, T, const T*, int, const T*, int, T, T*, int);
+        using getrf_type = int (*)(int, int, int, T*, int, int*);
+        using potrf_type = int (*)(int, char, int, T*, int);
+        using trsm_type = void (*)(int, int, int, int, int, int, int, T, const T*, int, T*, int);
+        using getrs_type = int (*)(int, char, int, int, const T*, int, const int*, T*, int);
+        using potrs_type = int (*)(int, char, int, int, const T*, int, T*, int);
+        using fortran_getrf_type = void (*)(const int*, const int*, T*, const int*, int*, int*);
+        using fortran_potrf_type = void (*)(const char*, const int*, T*, const int*, int*);
+
+        gemm_type gemm = nullptr;
+        getrf_type getrf = nullptr;
+        potrf_type potrf = nullptr;
+        trsm_type trsm = nullptr;
+        getrs_type getrs = nullptr;
+        potrs_type potrs = nullptr;
+        fortran_getrf_type fortran_getrf = nullptr;
+        fortran_potrf_type fortran_potrf = nullptr;
+    };
+
+#if defined(MATRIX_BLAS_DLOPEN)
+    inline void* __blas_library() {
+        static void* result = [] {
+            const char* candidates[] = {
+                std::getenv("MATRIX_BLAS_LIBRARY"), "libopenblas.so.0", "libopenblas.so",
+                "libblis.so.4", "libblis.so", "libcblas.so.3", "libblas.so.3"
+            };
+
+            for (const char* name : candidates) {
+                void* handle = (name != nullptr) ? dlopen(name, RTLD_NOW | RTLD_LOCAL) : nullptr;
+
+                if (handle != nullptr) {
+                    return handle;
+                }
+            }
+
+            return static_cast<void*>(nullptr);
+        }();
+
+        return result;
+    }
+
+    inline void* __lapack_library() {
+        static void* result = [] {
+            const char* candidates[] = {"liblapacke.so.3", "liblapacke.so", "liblapack.so.3", "liblapack.so"};
+
+            for (const char* name : candidates) {
+                void* handle = dlopen(name, RTLD_NOW | RTLD_LOCAL);
+
+                if (handle != nullptr) {
+                    return handle;
+                }
+            }
+
+            return static_cast<void*>(nullptr);
+        }();
+
+        return result;
+    }
+
+    template<typename F>
+    F __blas_symbol(const char* name) {
+        void* symbol = nullptr;
+
+        for (void* handle : {__blas_library(), __lapack_library()}) {
+            if ((symbol == nullptr) && (handle != nullptr)) {
+                symbol = dlsym(handle, name);
             }
+        }
+
+        F result = reinterpret_cast<F>(symbol);
+        return result;
+    }
+#endif
+
+    template<typename T>
+    __blas_routines<T> __load_blas() {
+        __blas_routines<T> result;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            [[maybe_unused]] constexpr bool single = std::is_same_v<T, float>;
+#if defined(MATRIX_BLAS_DLOPEN)
+            using routines = __blas_routines<T>;
+            result.gemm = __blas_symbol<typename routines::gemm_type>(single ? "cblas_sgemm" : "cblas_dgemm");
+            result.getrf = __blas_symbol<typename routines::getrf_type>(single ? "LAPACKE_sgetrf" : "LAPACKE_dgetrf");
+            result.potrf = __blas_symbol<typename routines::potrf_type>(single ? "LAPACKE_spotrf" : "LAPACKE_dpotrf");
+            result.trsm = __blas_symbol<typename routines::trsm_type>(single ? "cblas_strsm" : "cblas_dtrsm");
+            result.getrs = __blas_symbol<typename routines::getrs_type>(single ? "LAPACKE_sgetrs" : "LAPACKE_dgetrs");
+            result.potrs = __blas_symbol<typename routines::potrs_type>(single ? "LAPACKE_spotrs" : "LAPACKE_dpotrs");
+            result.fortran_getrf = __blas_symbol<typename routines::fortran_getrf_type>(single ? "sgetrf_" : "dgetrf_");
+            result.fortran_potrf = __blas_symbol<typename routines::fortran_potrf_type>(single ? "spotrf_" : "dpotrf_");
 #endif
-            matrix<T> result(m_rows, m_columns);
+#if defined(MATRIX_USE_CBLAS)
+            result.gemm = [](int, int trans_a, int trans_b, int m, int n, int k, T alpha, const T* a, int lda, const T* b, int ldb, T beta, T* c, int ldc) {
+                if constexpr (single) {
+                    cblas_sgemm(CblasRowMajor, (trans_a == 112) ? CblasTrans : CblasNoTrans, (trans_b == 112) ? CblasTrans : CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+                } else {
+                    cblas_dgemm(CblasRowMajor, (trans_a == 112) ? CblasTrans : CblasNoTrans, (trans_b == 112) ? CblasTrans : CblasNoTrans, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+                }
+            };
+            result.trsm = [](int, int, int uplo, int trans, int diag, int m, int n, T alpha, const T* a, int lda, T* b, int ldb) {
+                if constexpr (single) {
+                    cblas_strsm(CblasRowMajor, CblasLeft, (uplo == 122) ? CblasLower : CblasUpper, (trans == 112) ? CblasTrans : CblasNoTrans, (diag == 132) ? CblasUnit : CblasNonUnit, m, n, alpha, a, lda, b, ldb);
+                } else {
+                    cblas_dtrsm(CblasRowMajor, CblasLeft, (uplo == 122) ? CblasLower : CblasUpper, (trans == 112) ? CblasTrans : CblasNoTrans, (diag == 132) ? CblasUnit : CblasNonUnit, m, n, alpha, a, lda, b, ldb);
+                }
+            };
+#endif
+#if defined(MATRIX_USE_LAPACKE)
+            result.getrf = [](int, int m, int n, T* a, int lda, int* pivots) {
+                int info;
+
+                if constexpr (single) {
+                    info = LAPACKE_sgetrf(LAPACK_ROW_MAJOR, m, n, a, lda, pivots);
+                } else {
+                    info = LAPACKE_dgetrf(LAPACK_ROW_MAJOR, m, n, a, lda, pivots);
+                }
+
+                return info;
+            };
+            result.potrf = [](int, char uplo, int n, T* a, int lda) {
+                int info;
+
+                if constexpr (single) {
+                    info = LAPACKE_spotrf(LAPACK_ROW_MAJOR, uplo, n, a, lda);
+                } else {
+                    info = LAPACKE_dpotrf(LAPACK_ROW_MAJOR, uplo, n, a, lda);
+                }
+
+                return info;
+            };
+            result.getrs = [](int, char trans, int n, int nrhs, const T* a, int lda, const int* pivots, T* b, int ldb) {
+                int info;
+
+                if constexpr (single) {
+                    info = LAPACKE_sgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, a, lda, pivots, b, ldb);
+                } else {
+                    info = LAPACKE_dgetrs(LAPACK_ROW_MAJOR, trans, n, nrhs, a, lda, pivots, b, ldb);
+                }
+
+                return info;
+            };
+            result.potrs = [](int, char uplo, int n, int nrhs, const T* a, int lda, T* b, int ldb) {
+                int info;
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    result(row, column) = (*this)(row, column) + operand(row, column);
+                if constexpr (single) {
+                    info = LAPACKE_spotrs(LAPACK_ROW_MAJOR, uplo, n, nrhs, a, lda, b, ldb);
+                } else {
+                    info = LAPACKE_dpotrs(LAPACK_ROW_MAJOR, uplo, n, nrhs, a, lda, b, ldb);
                 }
+
+                return info;
+            };
+#endif
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    const __blas_routines<T>& __blas() {
+        static const __blas_routines<T> result = __load_blas<T>();
+        return result;
+    }
+
+    // Maps a view onto a row-major BLAS operand: one of the strides must be
+    // unit and the other a valid leading dimension.
+    template<typename T, bool Conjugate>
+    bool __blas_operand(const matrix_view<T, Conjugate>& view, int& transpose, int& leading) {
+        bool result = true;
+
+        if ((view.column_stride() == 1) && (view.row_stride() >= std::max<size_t>(view.columns(), 1))) {
+            transpose = 111;
+            leading = static_cast<int>(view.row_stride());
+        } else if ((view.row_stride() == 1) && (view.column_stride() >= std::max<size_t>(view.rows(), 1))) {
+            transpose = 112;
+            leading = static_cast<int>(view.column_stride());
+        } else {
+            result = false;
+        }
+
+        return result;
+    }
+
+    template<typename T, typename TA, bool CA, typename TB, bool CB>
+    bool __blas_gemm(T alpha, const matrix_view<TA, CA>& a, const matrix_view<TB, CB>& b, T beta, const matrix_view<T>& c) {
+        bool result = false;
+
+        if constexpr ((std::is_same_v<T, float> || std::is_same_v<T, double>) && std::is_same_v<std::remove_const_t<TA>, T> && std::is_same_v<std::remove_const_t<TB>, T>) {
+            size_t threshold = blas_threshold * blas_threshold * blas_threshold;
+            auto gemm = __blas<T>().gemm;
+            int trans_a, trans_b, trans_c, lda, ldb, ldc;
+
+            if ((gemm == nullptr) || (c.rows() * c.columns() * a.columns() < threshold) || (a.columns() == 0)) {
+                return result;
             }
 
-            return result;
+            if (!__blas_operand(a, trans_a, lda) || !__blas_operand(b, trans_b, ldb) || !__blas_operand(c, trans_c, ldc)) {
+                return result;
+            }
+
+            if (trans_c == 111) {
+                gemm(101, trans_a, trans_b, c.rows(), c.columns(), a.columns(), alpha, a.data(), lda, b.data(), ldb, beta, c.data(), ldc);
+            } else {
+                // Column-major C: compute C^T = B^T * A^T instead.
+                gemm(101, 223 - trans_b, 223 - trans_a, c.columns(), c.rows(), a.columns(), alpha, b.data(), ldb, a.data(), lda, beta, c.data(), ldc);
+            }
+
+            result = true;
         }
 
-        matrix<T> operator-(matrix<T>& operand) {
+        return result;
+    }
+
+    // C = alpha * A * B + beta * C over arbitrary strides. Operand panels are
+    // packed into contiguous buffers (applying conjugation on the way), so a
+    // transposed or conjugated view costs no more than a plain matrix.
+    template<typename T, typename TA, bool CA, typename TB, bool CB>
+    void gemm(T alpha, const matrix_view<TA, CA>& a, const matrix_view<TB, CB>& b, T beta, const matrix_view<T>& c) {
 #ifndef MATRIX_NOTHROW
-            if ((m_rows != operand.m_rows) || (m_columns != operand.m_columns)) {
-                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
-            }
+        if ((a.columns() != b.rows()) || (a.rows() != c.rows()) || (b.columns() != c.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
 #endif
-            matrix<T> result(m_rows, m_columns);
+        if (__blas_gemm(alpha, a, b, beta, c)) {
+            return;
+        }
+
+        constexpr size_t MR = 4;
+        constexpr size_t NR = 8;
+        constexpr size_t MC = 128;
+        constexpr size_t KC = 256;
+        constexpr size_t NC = 2048;
+
+        size_t m = c.rows();
+        size_t n = c.columns();
+        size_t k = a.columns();
+        T* c_data = c.data();
+
+        for (size_t row = 0; row < m; row++) {
+            for (size_t column = 0; column < n; column++) {
+                T& element = c_data[row * c.row_stride() + column * c.column_stride()];
+                element = (beta == T()) ? T() : beta * element;
+            }
+        }
+
+        std::vector<T> packed_a;
+        std::vector<T> packed_b;
+
+        for (size_t jc = 0; jc < n; jc += NC) {
+            size_t nc = std::min(NC, n - jc);
+            size_t n_panels = (nc + NR - 1) / NR;
+
+            for (size_t pc = 0; pc < k; pc += KC) {
+                size_t kc = std::min(KC, k - pc);
+                packed_b.assign(n_panels * NR * kc, T());
+
+                for (size_t panel = 0; panel < n_panels; panel++) {
+                    T* destination = packed_b.data() + panel * NR * kc;
+                    size_t width = std::min(NR, nc - panel * NR);
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    result(row, column) = (*this)(row, column) - operand(row, column);
+                    for (size_t p = 0; p < kc; p++) {
+                        for (size_t j = 0; j < width; j++) {
+                            destination[p * NR + j] = __element(b, pc + p, jc + panel * NR + j);
+                        }
+                    }
+                }
+
+                for (size_t ic = 0; ic < m; ic += MC) {
+                    size_t mc = std::min(MC, m - ic);
+                    size_t m_panels = (mc + MR - 1) / MR;
+                    packed_a.assign(m_panels * MR * kc, T());
+
+                    for (size_t panel = 0; panel < m_panels; panel++) {
+                        T* destination = packed_a.data() + panel * MR * kc;
+                        size_t height = std::min(MR, mc - panel * MR);
+
+                        for (size_t p = 0; p < kc; p++) {
+                            for (size_t i = 0; i < height; i++) {
+                                destination[p * MR + i] = __element(a, ic + panel * MR + i, pc + p);
+                            }
+                        }
+                    }
+
+                    for (size_t panel_b = 0; panel_b < n_panels; panel_b++) {
+                        const T* block_b = packed_b.data() + panel_b * NR * kc;
+                        size_t width = std::min(NR, nc - panel_b * NR);
+
+                        for (size_t panel_a = 0; panel_a < m_panels; panel_a++) {
+                            const T* block_a = packed_a.data() + panel_a * MR * kc;
+                            size_t height = std::min(MR, mc - panel_a * MR);
+                            T accumulator[MR][NR] = {};
+
+                            for (size_t p = 0; p < kc; p++) {
+                                for (size_t i = 0; i < MR; i++) {
+                                    for (size_t j = 0; j < NR; j++) {
+                                        accumulator[i][j] = accumulator[i][j] + block_a[p * MR + i] * block_b[p * NR + j];
+                                    }
+                                }
+                            }
+
+                            for (size_t i = 0; i < height; i++) {
+                                for (size_t j = 0; j < width; j++) {
+                                    size_t row = ic + panel_a * MR + i;
+                                    size_t column = jc + panel_b * NR + j;
+                                    T& element = c_data[row * c.row_stride() + column * c.column_stride()];
+                                    element = element + alpha * accumulator[i][j];
+                                }
+                            }
+                        }
+                    }
                 }
             }
+        }
+    }
+
+    template<size_t Rows>
+    class __row_extent {
+    protected:
+        constexpr __row_extent(size_t) {
+
+        }
+
+        constexpr size_t __rows() const {
+            size_t result = Rows;
+            return result;
+        }
+    };
+
+    template<>
+    class __row_extent<dyn> {
+    protected:
+        size_t m_rows;
+
+        constexpr __row_extent(size_t rows) : m_rows(rows) {
+
+        }
 
+        constexpr size_t __rows() const {
+            size_t result = m_rows;
             return result;
         }
+    };
 
-        matrix<T> operator-() {
-            matrix<T> result(m_rows, m_columns);
+    template<size_t Columns>
+    class __column_extent {
+    protected:
+        constexpr __column_extent(size_t) {
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    result(row, column) = -result(row, column);
-                }
-            }
+        }
 
+        constexpr size_t __columns() const {
+            size_t result = Columns;
             return result;
         }
+    };
 
-        matrix<T> operator*(T operand) {
-            matrix<T> result(m_rows, m_columns);
+    template<>
+    class __column_extent<dyn> {
+    protected:
+        size_t m_columns;
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    result(row, column) = result(row, column) + operand;
-                }
-            }
+        constexpr __column_extent(size_t columns) : m_columns(columns) {
+
+        }
 
+        constexpr size_t __columns() const {
+            size_t result = m_columns;
             return result;
         }
+    };
+
+    template<typename T, size_t Size>
+    struct __storage {
+        using type = std::array<T, Size>;
+    };
+
+    template<typename T>
+    struct __storage<T, dyn> {
+        using type = std::vector<T>;
+    };
+
+    // Any extent may be fixed at compile time (matrix<T, dyn, 3>). Static
+    // extents occupy no storage, are checked with static_assert instead of a
+    // runtime branch, and a fully static matrix keeps its elements inline and
+    // supports construction, access, arithmetic, transpose, minor and
+    // determinant in constant expressions.
+    template<typename T, size_t Rows, size_t Columns>
+    class matrix : private __row_extent<Rows>, private __column_extent<Columns> {
+    private:
+        template<typename, size_t, size_t>
+        friend class matrix;
+
+        typename __storage<T, (Rows == dyn || Columns == dyn) ? dyn : Rows * Columns>::type m_data{};
+
+    public:
+        static constexpr size_t static_rows = Rows;
+        static constexpr size_t static_columns = Columns;
+
+        constexpr matrix() : __row_extent<Rows>(Rows == dyn ? 0 : Rows), __column_extent<Columns>(Columns == dyn ? 0 : Columns) {
+            if constexpr (Rows == dyn || Columns == dyn) {
+                m_data.resize(rows() * columns());
+            }
+        }
+
+        template<size_t R = Rows, size_t C = Columns, std::enable_if_t<(R != dyn) && (C != dyn), int> = 0>
+        constexpr matrix(std::initializer_list<T> elements) : matrix() {
+            (*this) = elements;
+        }
 
-        matrix<T> operator*(matrix<T> operand) {
+        constexpr matrix(size_t rows, size_t columns, T fill = T()) : __row_extent<Rows>(rows), __column_extent<Columns>(columns) {
 #ifndef MATRIX_NOTHROW
-            if (m_columns != operand.m_rows) {
-                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            if ((rows < 1) || (columns < 1)) {
+                throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+            }
+
+            if (((Rows != dyn) && (rows != Rows)) || ((Columns != dyn) && (columns != Columns))) {
+                throw std::runtime_error(__error_messages[ERR_STATIC_EXTENT]);
             }
 #endif
-            matrix<T> result(m_rows, operand.m_columns);
+            if constexpr (Rows == dyn || Columns == dyn) {
+                m_data.resize(rows * columns);
+            }
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < operand.m_columns; column++) {
-                    for (size_t element = 0; element < m_columns; element++) {
-                        result(row, column) = result(row, column) + (*this)(row, element) * operand(element, column);
-                    }
-                }
+            for (size_t index = 0; index < rows * columns; index++) {
+                m_data[index] = fill;
             }
+        }
 
-            return result;
+        template<size_t R, size_t C, std::enable_if_t<__widening_extent(Rows, R) && __widening_extent(Columns, C), int> = 0>
+        constexpr matrix(const matrix<T, R, C>& other) : matrix(other.rows(), other.columns()) {
+            for (size_t index = 0; index < size(); index++) {
+                m_data[index] = other.m_data[index];
+            }
         }
 
-        matrix<T> transpose() {
-            matrix<T> result(m_columns, m_rows);
+        template<size_t R, size_t C, std::enable_if_t<!(__widening_extent(Rows, R) && __widening_extent(Columns, C)), int> = 0>
+        constexpr explicit matrix(const matrix<T, R, C>& other) : matrix(other.rows(), other.columns()) {
+            static_assert(__compatible_extent(Rows, R) && __compatible_extent(Columns, C), "incompatible matrix dimensions.");
+
+            for (size_t index = 0; index < size(); index++) {
+                m_data[index] = other.m_data[index];
+            }
+        }
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    result(column, row) = (*this)(row, column);
+        template<typename U, bool Conjugate>
+        explicit matrix(const matrix_view<U, Conjugate>& view) : matrix(view.rows(), view.columns()) {
+            for (size_t row = 0; row < rows(); row++) {
+                for (size_t column = 0; column < columns(); column++) {
+                    m_data[row * columns() + column] = __element(view, row, column);
                 }
             }
+        }
+
+        constexpr matrix(const matrix<T, Rows, Columns>& other) = default;
+        constexpr matrix(matrix<T, Rows, Columns>&& other) = default;
+        constexpr matrix<T, Rows, Columns>& operator=(const matrix<T, Rows, Columns>& other) = default;
+        constexpr matrix<T, Rows, Columns>& operator=(matrix<T, Rows, Columns>&& other) = default;
 
+        ~matrix() = default;
+
+        constexpr size_t rows() const {
+            size_t result = __row_extent<Rows>::__rows();
             return result;
         }
 
-        matrix<T> minor(size_t at_row, size_t at_column) {
-            matrix<T> result(m_rows - 1, m_columns - 1);
-            size_t index = 0;
+        constexpr size_t columns() const {
+            size_t result = __column_extent<Columns>::__columns();
+            return result;
+        }
 
-            for (size_t row = 0; row < m_rows; row++) {
-                for (size_t column = 0; column < m_columns; column++) {
-                    if (row == at_row) { continue; }
-                    if (column == at_column) { continue; }
-                    result.m_data[index++] = (*this)(row, column);
-                }
-            }
+        constexpr T* data() {
+            T* result = m_data.data();
+            return result;
+        }
 
+        constexpr const T* data() const {
+            const T* result = m_data.data();
             return result;
         }
 
-        T determinant() {
-#ifndef MATRIX_NOTHROW
-            if (m_rows != m_columns) {
-                throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
-            }
+        constexpr size_t size() const {
+            size_t result = rows() * columns();
+            return result;
+        }
+
+        constexpr size_t row_stride() const {
+            size_t result = columns();
+            return result;
+        }
+
+        constexpr size_t column_stride() const {
+            size_t result = 1;
+            return result;
+        }
+
+#ifdef __cpp_lib_span
+        std::span<T> span() {
+            std::span<T> result(m_data.data(), size());
+            return result;
+        }
+
+        std::span<const T> span() const {
+            std::span<const T> result(m_data.data(), size());
+            return result;
+        }
 #endif
-            T result = T();
 
-            if (m_rows == 1) {
-                result = (*this)(0, 0);
-            } else if (m_rows == 2) {
-                result = (*this)(0, 0) * (*this)(1, 1) - (*this)(1, 0) * (*this)(0, 1);
-            } else {
-                for (size_t row = 0; row < m_rows; row++) {
-                    matrix<T> sub_matrix = (*this).minor(row, 0);
-                    T sub_result = (*this)(row, 0) * sub_matrix.determinant();
+#ifdef MATRIX_MDSPAN_NAMESPACE
+        // dyn equals std::dynamic_extent, so the static extents carry over.
+        MATRIX_MDSPAN_NAMESPACE::mdspan<T, MATRIX_MDSPAN_NAMESPACE::extents<size_t, Rows, Columns>> to_mdspan() {
+            MATRIX_MDSPAN_NAMESPACE::mdspan<T, MATRIX_MDSPAN_NAMESPACE::extents<size_t, Rows, Columns>> result(m_data.data(), rows(), columns());
+            return result;
+        }
 
-                    if (row % 2 == 0) {
-                        result = result + sub_result;
-                    } else {
-                        result = result - sub_result;
-                    }
-                }
-            }
+        MATRIX_MDSPAN_NAMESPACE::mdspan<const T, MATRIX_MDSPAN_NAMESPACE::extents<size_t, Rows, Columns>> to_mdspan() const {
+            MATRIX_MDSPAN_NAMESPACE::mdspan<const T, MATRIX_MDSPAN_NAMESPACE::extents<size_t, Rows, Columns>> result(m_data.data(), rows(), columns());
+            return result;
+        }
+#endif
 
+        matrix_view<T> view() {
+            matrix_view<T> result(m_data.data(), rows(), columns(), columns(), 1);
             return result;
         }
+
+        matrix_view<const T> view() const {
+            matrix_view<const T> result(m_data.data(), rows(), columns(), columns(), 1);
+            return result;
+        }
+
+        matrix_view<T> t() {
+            matrix_view<T> result = view().t();
+            return result;
+        }
+
+        matrix_view<const T> t() const {
+            matrix_view<const T> result = view().t();
+            return result;
+        }
+
+        matrix_view<const T, true> conj() const {
+            matrix_view<const T, true> result = view().conj();
+            return result;
+        }
+
+        matrix_view<const T, true> h() const {
+            matrix_view<const T, true> result = view().h();
+            return result;
+        }
+
+        matrix_view<T> block(size_t row, size_t column, size_t rows, size_t columns) {
+            matrix_view<T> result = view().block(row, column, rows, columns);
+            return result;
+        }
+
+        matrix_view<const T> block(size_t row, size_t column, size_t rows, size_t columns) const {
+            matrix_view<const T> result = view().block(row, column, rows, columns);
+            return result;
+        }
+
+        // Room for `rows` rows in total, so appending up to that many rows
+        // does not reallocate. The column count must already be known.
+        template<size_t R = Rows, std::enable_if_t<R == dyn, int> = 0>
+        void reserve_rows(size_t rows) {
+            m_data.reserve(rows * columns());
+        }
+
+        // Appends the rows of a matrix or view at the bottom. Storage grows
+        // geometrically, so streaming n rows in costs amortized O(1) copies
+        // per row. An empty matrix takes its column count from the first rows.
+        template<typename S, size_t R = Rows, std::enable_if_t<R == dyn, int> = 0>
+        void append_rows(const S& operand) {
+            auto source = __as_view(operand);
+            const T* begin = m_data.data();
+
+            if (!m_data.empty() && !std::less<const T*>()(source.data(), begin) && std::less<const T*>()(source.data(), begin + m_data.size())) {
+                // The source lives in this matrix and would move on growth.
+                matrix<T> copy(source);
+                append_rows(copy);
+                return;
+            }
+
+            if constexpr (Columns == dyn) {
+                if (m_data.empty() && (rows() == 0)) {
+                    this->m_columns = source.columns();
+                }
+            }
+#ifndef MATRIX_NOTHROW
+            if (source.columns() != columns()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            size_t offset = m_data.size();
+            m_data.resize(offset + source.rows() * columns());
+            matrix_view<T> target(m_data.data() + offset, source.rows(), columns(), columns(), 1);
+
+            for (size_t row = 0; row < source.rows(); row++) {
+                __copy_row(source, row, target, row);
+            }
+
+            this->m_rows = this->m_rows + source.rows();
+        }
+
+        template<typename S, size_t R = Rows, std::enable_if_t<R == dyn, int> = 0>
+        void append_row(const S& operand) {
+#ifndef MATRIX_NOTHROW
+            if (__as_view(operand).rows() != 1) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            append_rows(operand);
+        }
+
+        template<size_t R = Rows, std::enable_if_t<R == dyn, int> = 0>
+        void append_row(std::initializer_list<T> values) {
+            append_rows(matrix_view<const T>(values.begin(), 1, values.size(), values.size(), 1));
+        }
+
+        // Reshapes in place, keeping the overlapping top-left elements and
+        // filling new ones with T(). When the column count changes the rows
+        // are shifted within the one buffer instead of copied into a new one.
+        template<size_t R = Rows, size_t C = Columns, std::enable_if_t<(R == dyn) || (C == dyn), int> = 0>
+        void resize(size_t rows, size_t columns) {
+#ifndef MATRIX_NOTHROW
+            if (((Rows != dyn) && (rows != Rows)) || ((Columns != dyn) && (columns != Columns))) {
+                throw std::runtime_error(__error_messages[ERR_STATIC_EXTENT]);
+            }
+#endif
+            size_t old_columns = this->columns();
+            size_t kept = std::min(this->rows(), rows);
+
+            if (columns < old_columns) {
+                for (size_t row = 1; row < kept; row++) {
+                    std::move(m_data.begin() + row * old_columns, m_data.begin() + row * old_columns + columns, m_data.begin() + row * columns);
+                }
+            } else if (columns > old_columns) {
+                m_data.resize(std::max(m_data.size(), rows * columns));
+
+                for (size_t row = kept; row-- > 1;) {
+                    std::move_backward(m_data.begin() + row * old_columns, m_data.begin() + (row + 1) * old_columns, m_data.begin() + row * columns + old_columns);
+                }
+
+                for (size_t row = 0; row < kept; row++) {
+                    std::fill(m_data.begin() + row * columns + old_columns, m_data.begin() + (row + 1) * columns, T());
+                }
+            }
+
+            m_data.resize(rows * columns);
+            std::fill(m_data.begin() + kept * columns, m_data.end(), T());
+
+            if constexpr (Rows == dyn) {
+                this->m_rows = rows;
+            }
+
+            if constexpr (Columns == dyn) {
+                this->m_columns = columns;
+            }
+        }
+
+        // Zero-copy view of the elements as a rows x columns matrix.
+        matrix_view<T> reshape(size_t rows, size_t columns) {
+            matrix_view<T> result = view().reshape(rows, columns);
+            return result;
+        }
+
+        matrix_view<const T> reshape(size_t rows, size_t columns) const {
+            matrix_view<const T> result = view().reshape(rows, columns);
+            return result;
+        }
+
+        constexpr matrix<T, 1, Columns> row_vector(size_t row) const {
+#ifndef MATRIX_NOTHROW
+            if ((row < 0) || (row >= rows())) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+#endif
+            matrix<T, 1, Columns> result(1, columns());
+
+            for (size_t column = 0; column < columns(); column++) {
+                result(0, column) = (*this)(row, column);
+            }
+
+            return result;
+        }
+
+        constexpr matrix<T, Rows, 1> column_vector(size_t column) const {
+#ifndef MATRIX_NOTHROW
+            if ((column < 0) || (column >= columns())) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+#endif
+            matrix<T, Rows, 1> result(rows(), 1);
+
+            for (size_t row = 0; row < rows(); row++) {
+                result(row, 0) = (*this)(row, column);
+            }
+
+            return result;
+        }
+
+        template <typename L>
+        constexpr matrix<T, Rows, Columns>& transform(L&& lambda) {
+            matrix<T, Rows, Columns>& result = (*this);
+
+            for (size_t row = 0; row < rows(); row++) {
+                for (size_t column = 0; column < columns(); column++) {
+                    lambda(row, column, result(row, column));
+                }
+            }
+
+            return result;
+        }
+
+        constexpr T& operator()(size_t row, size_t column) {
+#ifndef MATRIX_NOTHROW
+            if ((row < 0) || (row >= rows())) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+
+            if ((column < 0) || (column >= columns())) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+#endif
+            T& result = m_data[row * columns() + column];
+            return result;
+        }
+
+        constexpr const T& operator()(size_t row, size_t column) const {
+#ifndef MATRIX_NOTHROW
+            if ((row < 0) || (row >= rows())) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+
+            if ((column < 0) || (column >= columns())) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+#endif
+            const T& result = m_data[row * columns() + column];
+            return result;
+        }
+
+        constexpr matrix<T, Rows, Columns>& operator=(std::initializer_list<T> operand) {
+#ifndef MATRIX_NOTHROW
+            if (rows() * columns() != operand.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            matrix<T, Rows, Columns>& result = (*this);
+            size_t index = 0;
+
+            for (const T& element : operand) {
+                result.m_data[index++] = element;
+            }
+
+            return result;
+        }
+
+        template<size_t R, size_t C>
+        constexpr matrix<T, __common_extent(Rows, R), __common_extent(Columns, C)> operator+(const matrix<T, R, C>& operand) const {
+            static_assert(__compatible_extent(Rows, R) && __compatible_extent(Columns, C), "incompatible matrix dimensions.");
+#ifndef MATRIX_NOTHROW
+            if constexpr (Rows == dyn || R == dyn || Columns == dyn || C == dyn) {
+                if ((rows() != operand.rows()) || (columns() != operand.columns())) {
+                    throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                }
+            }
+#endif
+            matrix<T, __common_extent(Rows, R), __common_extent(Columns, C)> result(rows(), columns());
+
+            for (size_t index = 0; index < rows() * columns(); index++) {
+                result.m_data[index] = m_data[index] + operand.m_data[index];
+            }
+
+            return result;
+        }
+
+        template<size_t R, size_t C>
+        constexpr matrix<T, __common_extent(Rows, R), __common_extent(Columns, C)> operator-(const matrix<T, R, C>& operand) const {
+            static_assert(__compatible_extent(Rows, R) && __compatible_extent(Columns, C), "incompatible matrix dimensions.");
+#ifndef MATRIX_NOTHROW
+            if constexpr (Rows == dyn || R == dyn || Columns == dyn || C == dyn) {
+                if ((rows() != operand.rows()) || (columns() != operand.columns())) {
+                    throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                }
+            }
+#endif
+            matrix<T, __common_extent(Rows, R), __common_extent(Columns, C)> result(rows(), columns());
+
+            for (size_t index = 0; index < rows() * columns(); index++) {
+                result.m_data[index] = m_data[index] - operand.m_data[index];
+            }
+
+            return result;
+        }
+
+        constexpr matrix<T, Rows, Columns> operator-() const {
+            matrix<T, Rows, Columns> result(*this);
+
+            for (size_t index = 0; index < size(); index++) {
+                result.m_data[index] = -m_data[index];
+            }
+
+            return result;
+        }
+
+        constexpr matrix<T, Rows, Columns> operator*(T operand) const {
+            matrix<T, Rows, Columns> result(*this);
+
+            for (size_t index = 0; index < size(); index++) {
+                result.m_data[index] = m_data[index] * operand;
+            }
+
+            return result;
+        }
+
+        template<size_t R, size_t C>
+        constexpr matrix<T, Rows, C> operator*(const matrix<T, R, C>& operand) const {
+            static_assert(__compatible_extent(Columns, R), "incompatible matrix dimensions.");
+#ifndef MATRIX_NOTHROW
+            if constexpr (Columns == dyn || R == dyn) {
+                if (columns() != operand.rows()) {
+                    throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                }
+            }
+#endif
+            constexpr size_t inner = __common_extent(Columns, R);
+            matrix<T, Rows, C> result(rows(), operand.columns());
+
+            if constexpr ((inner != dyn) && ((inner <= 16) || ((Rows != dyn) && (C != dyn)))) {
+                // A short static inner dimension is fully unrolled; packing
+                // operands for the blocked kernel would cost more than it saves.
+                // Fully static products always take this path so they stay
+                // usable in constant expressions.
+                for (size_t row = 0; row < rows(); row++) {
+                    for (size_t column = 0; column < operand.columns(); column++) {
+                        T sum = T();
+
+                        for (size_t element = 0; element < inner; element++) {
+                            sum = sum + m_data[row * inner + element] * operand.m_data[element * operand.columns() + column];
+                        }
+
+                        result.m_data[row * operand.columns() + column] = sum;
+                    }
+                }
+            } else {
+                gemm(T(1), view(), operand.view(), T(), result.view());
+            }
+
+            return result;
+        }
+
+        constexpr matrix<T, Columns, Rows> transpose() const {
+            matrix<T, Columns, Rows> result(columns(), rows());
+
+            for (size_t row = 0; row < rows(); row++) {
+                for (size_t column = 0; column < columns(); column++) {
+                    result.m_data[column * rows() + row] = m_data[row * columns() + column];
+                }
+            }
+
+            return result;
+        }
+
+        constexpr matrix<T, __reduce_extent(Rows), __reduce_extent(Columns)> minor(size_t at_row, size_t at_column) const {
+            matrix<T, __reduce_extent(Rows), __reduce_extent(Columns)> result(rows() - 1, columns() - 1);
+            size_t index = 0;
+
+            for (size_t row = 0; row < rows(); row++) {
+                for (size_t column = 0; column < columns(); column++) {
+                    if (row == at_row) { continue; }
+                    if (column == at_column) { continue; }
+                    result.m_data[index++] = (*this)(row, column);
+                }
+            }
+
+            return result;
+        }
+
+        constexpr T determinant() const {
+            static_assert(__compatible_extent(Rows, Columns), "matrix must be square [rows = columns].");
+#ifndef MATRIX_NOTHROW
+            if constexpr (Rows == dyn || Columns == dyn) {
+                if (rows() != columns()) {
+                    throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+                }
+            }
+#endif
+            constexpr size_t extent = __common_extent(Rows, Columns);
+            T result = T();
+
+            if (rows() == 1) {
+                result = (*this)(0, 0);
+            } else if (rows() == 2) {
+                result = (*this)(0, 0) * (*this)(1, 1) - (*this)(1, 0) * (*this)(0, 1);
+            } else if constexpr (extent == dyn || extent > 2) {
+                for (size_t row = 0; row < rows(); row++) {
+                    auto sub_matrix = (*this).minor(row, 0);
+                    T sub_result = (*this)(row, 0) * sub_matrix.determinant();
+
+                    if (row % 2 == 0) {
+                        result = result + sub_result;
+                    } else {
+                        result = result - sub_result;
+                    }
+                }
+            }
+
+            return result;
+        }
+    };
+
+    template<typename T, size_t Rows, size_t Columns>
+    matrix_view<const T> __as_view(const matrix<T, Rows, Columns>& operand) {
+        matrix_view<const T> result = operand.view();
+        return result;
+    }
+
+    template<typename T, bool Conjugate>
+    matrix_view<const T, Conjugate> __as_view(const matrix_view<T, Conjugate>& operand) {
+        matrix_view<const T, Conjugate> result(operand.data(), operand.rows(), operand.columns(), operand.row_stride(), operand.column_stride());
+        return result;
+    }
+
+    template<typename L, typename R>
+    using __enable_if_view_operands = std::enable_if_t<__is_view<L>::value || __is_view<R>::value>;
+
+    template<typename L, typename R, typename = __enable_if_view_operands<L, R>>
+    auto operator+(const L& left, const R& right) {
+        auto a = __as_view(left);
+        auto b = __as_view(right);
+#ifndef MATRIX_NOTHROW
+        if ((a.rows() != b.rows()) || (a.columns() != b.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        matrix<typename decltype(a)::value_type> result(a.rows(), a.columns());
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t column = 0; column < a.columns(); column++) {
+                result(row, column) = __element(a, row, column) + __element(b, row, column);
+            }
+        }
+
+        return result;
+    }
+
+    template<typename L, typename R, typename = __enable_if_view_operands<L, R>>
+    auto operator-(const L& left, const R& right) {
+        auto a = __as_view(left);
+        auto b = __as_view(right);
+#ifndef MATRIX_NOTHROW
+        if ((a.rows() != b.rows()) || (a.columns() != b.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        matrix<typename decltype(a)::value_type> result(a.rows(), a.columns());
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t column = 0; column < a.columns(); column++) {
+                result(row, column) = __element(a, row, column) - __element(b, row, column);
+            }
+        }
+
+        return result;
+    }
+
+    template<typename L, typename R, typename = __enable_if_view_operands<L, R>>
+    auto operator*(const L& left, const R& right) {
+        auto a = __as_view(left);
+        auto b = __as_view(right);
+        using T = typename decltype(a)::value_type;
+#ifndef MATRIX_NOTHROW
+        if (a.columns() != b.rows()) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        matrix<T> result(a.rows(), b.columns());
+        gemm(T(1), a, b, T(), result.view());
+        return result;
+    }
+
+    // Product of the chain over [first, last] in the parenthesization chosen
+    // by multi_dot; split[first * n + last] is the last multiplication.
+    template<typename T>
+    matrix<T> __multi_dot(const std::vector<matrix_view<const T>>& operands, const std::vector<size_t>& split, size_t first, size_t last) {
+        size_t n = operands.size();
+        size_t k = split[first * n + last];
+        matrix_view<const T> a = operands[first];
+        matrix_view<const T> b = operands[k + 1];
+        matrix<T> left;
+        matrix<T> right;
+
+        if (k > first) {
+            left = __multi_dot(operands, split, first, k);
+            a = left.view();
+        }
+
+        if (k + 1 < last) {
+            right = __multi_dot(operands, split, k + 1, last);
+            b = right.view();
+        }
+
+        matrix<T> result(a.rows(), b.columns());
+        gemm(T(1), a, b, T(), result.view());
+        return result;
+    }
+
+    // Product of a chain of matrices or views, e.g. multi_dot(a, b, c, v).
+    // Unlike a * b * c * v, which multiplies left to right, the
+    // parenthesization with the fewest multiply-adds is found first by the
+    // classic O(n^3) dynamic program over the operand dimensions.
+    template<typename First, typename... Rest>
+    auto multi_dot(const First& first, const Rest&... rest) {
+        using T = typename decltype(__as_view(first))::value_type;
+        std::vector<matrix<T>> conjugated;
+        std::vector<matrix_view<const T>> operands;
+        conjugated.reserve(1 + sizeof...(Rest));
+
+        auto add = [&](const auto& operand) {
+            auto view = __as_view(operand);
+
+            if constexpr (std::is_same_v<decltype(view), matrix_view<const T>>) {
+                operands.push_back(view);
+            } else {
+                conjugated.emplace_back(view);
+                operands.push_back(conjugated.back().view());
+            }
+        };
+
+        add(first);
+        (add(rest), ...);
+
+        size_t n = operands.size();
+#ifndef MATRIX_NOTHROW
+        for (size_t index = 0; index + 1 < n; index++) {
+            if (operands[index].columns() != operands[index + 1].rows()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+        }
+#endif
+        if (n == 1) {
+            matrix<T> result(operands[0]);
+            return result;
+        }
+
+        std::vector<double> cost(n * n);
+        std::vector<size_t> split(n * n);
+
+        for (size_t length = 1; length < n; length++) {
+            for (size_t i = 0; i + length < n; i++) {
+                size_t j = i + length;
+                cost[i * n + j] = std::numeric_limits<double>::infinity();
+
+                for (size_t k = i; k < j; k++) {
+                    double flops = double(operands[i].rows()) * double(operands[k].columns()) * double(operands[j].columns());
+                    double candidate = cost[i * n + k] + cost[(k + 1) * n + j] + flops;
+
+                    if (candidate < cost[i * n + j]) {
+                        cost[i * n + j] = candidate;
+                        split[i * n + j] = k;
+                    }
+                }
+            }
+        }
+
+        matrix<T> result = __multi_dot(operands, split, 0, n - 1);
+        return result;
+    }
+
+    inline void __prefetch(const void* address) {
+#if defined(__GNUC__) || defined(__clang__)
+        __builtin_prefetch(address);
+#endif
+    }
+
+    // Copies row `from` of a view into row `to` of another, as one block copy
+    // when both rows are contiguous and unconjugated.
+    template<typename U, bool Conjugate, typename T>
+    void __copy_row(const matrix_view<U, Conjugate>& source, size_t from, const matrix_view<T>& target, size_t to) {
+        if (!Conjugate && (source.column_stride() == 1) && (target.column_stride() == 1)) {
+            const U* begin = source.data() + from * source.row_stride();
+            std::copy(begin, begin + source.columns(), target.data() + to * target.row_stride());
+        } else {
+            for (size_t column = 0; column < source.columns(); column++) {
+                target(to, column) = __element(source, from, column);
+            }
+        }
+    }
+
+    // Gathers rows indices[i] of a matrix or view into row i of a
+    // preallocated output, prefetching a few source rows ahead of the copy.
+    template<typename S, typename T>
+    void select_rows(const S& operand, const std::vector<size_t>& indices, const matrix_view<T>& output) {
+        auto source = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+        if ((output.rows() != indices.size()) || (output.columns() != source.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+
+        for (size_t index : indices) {
+            if (index >= source.rows()) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+        }
+#endif
+        const size_t distance = 4;
+
+        for (size_t row = 0; row < indices.size(); row++) {
+            if (row + distance < indices.size()) {
+                __prefetch(source.data() + indices[row + distance] * source.row_stride());
+            }
+
+            __copy_row(source, indices[row], output, row);
+        }
+    }
+
+    template<typename S>
+    auto select_rows(const S& operand, const std::vector<size_t>& indices) {
+        auto source = __as_view(operand);
+        matrix<typename decltype(source)::value_type> result(indices.size(), source.columns());
+        select_rows(source, indices, result.view());
+        return result;
+    }
+
+    // Gathers columns indices[j] into column j of the output, one source
+    // row at a time. Explicit SIMD gathers measured no faster than these
+    // indexed loads, which are bound by memory rather than instructions.
+    template<typename S, typename T>
+    void select_columns(const S& operand, const std::vector<size_t>& indices, const matrix_view<T>& output) {
+        auto source = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+        if ((output.rows() != source.rows()) || (output.columns() != indices.size())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+
+        for (size_t index : indices) {
+            if (index >= source.columns()) {
+                throw std::runtime_error(__error_messages[ERR_COL_RANGE]);
+            }
+        }
+#endif
+        for (size_t row = 0; row < source.rows(); row++) {
+            if (row + 1 < source.rows()) {
+                __prefetch(source.data() + (row + 1) * source.row_stride());
+            }
+
+            for (size_t column = 0; column < indices.size(); column++) {
+                output(row, column) = __element(source, row, indices[column]);
+            }
+        }
+    }
+
+    template<typename S>
+    auto select_columns(const S& operand, const std::vector<size_t>& indices) {
+        auto source = __as_view(operand);
+        matrix<typename decltype(source)::value_type> result(source.rows(), indices.size());
+        select_columns(source, indices, result.view());
+        return result;
+    }
+
+    // target row indices[i] += source row i; repeated indices accumulate.
+    template<typename S, typename T>
+    void scatter_add(const S& operand, const std::vector<size_t>& indices, const matrix_view<T>& target) {
+        auto source = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+        if ((source.rows() != indices.size()) || (source.columns() != target.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+
+        for (size_t index : indices) {
+            if (index >= target.rows()) {
+                throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+            }
+        }
+#endif
+        const size_t distance = 4;
+
+        for (size_t row = 0; row < indices.size(); row++) {
+            if (row + distance < indices.size()) {
+                __prefetch(target.data() + indices[row + distance] * target.row_stride());
+            }
+
+            for (size_t column = 0; column < source.columns(); column++) {
+                target(indices[row], column) = target(indices[row], column) + __element(source, row, column);
+            }
+        }
+    }
+
+    // The rows whose mask entry is set, in order (numpy.compress). The
+    // output must have as many rows as the mask has set entries.
+    template<typename S, typename T>
+    void compress_rows(const S& operand, const std::vector<bool>& mask, const matrix_view<T>& output) {
+        auto source = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+        if ((mask.size() != source.rows()) || (output.rows() != size_t(std::count(mask.begin(), mask.end(), true))) || (output.columns() != source.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        for (size_t row = 0, target = 0; row < source.rows(); row++) {
+            if (mask[row]) {
+                __copy_row(source, row, output, target++);
+            }
+        }
+    }
+
+    template<typename S>
+    auto compress_rows(const S& operand, const std::vector<bool>& mask) {
+        auto source = __as_view(operand);
+        matrix<typename decltype(source)::value_type> result(std::count(mask.begin(), mask.end(), true), source.columns());
+        compress_rows(source, mask, result.view());
+        return result;
+    }
+
+    // Overwrites the rows of target whose mask entry is set with the
+    // successive rows of the source (numpy.place); other rows are kept.
+    template<typename S, typename T>
+    void place_rows(const matrix_view<T>& target, const std::vector<bool>& mask, const S& operand) {
+        auto source = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+        if ((mask.size() != target.rows()) || (source.rows() != size_t(std::count(mask.begin(), mask.end(), true))) || (source.columns() != target.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        for (size_t row = 0, next = 0; row < target.rows(); row++) {
+            if (mask[row]) {
+                __copy_row(source, next++, target, row);
+            }
+        }
+    }
+
+    // Assembles a matrix from blocks in one pass. Blocks are appended left
+    // to right along a block row and next_row() starts the one below; build()
+    // allocates the result once and fills each output row from its pieces,
+    // rows in parallel. Only views are kept, so the pieces must outlive
+    // build(); conjugated or differently typed pieces are copied on append.
+    template<typename T>
+    class concatenation {
+    private:
+        static constexpr size_t npos = std::numeric_limits<size_t>::max();
+
+        // A piece is either a view or an index into m_owned.
+        struct piece {
+            matrix_view<const T> view;
+            size_t owned;
+        };
+
+        std::vector<std::vector<piece>> m_blocks;
+        std::vector<matrix<T>> m_owned;
+
+        matrix_view<const T> __view(const piece& block) const {
+            matrix_view<const T> result = (block.owned == npos) ? block.view : m_owned[block.owned].view();
+            return result;
+        }
+
+    public:
+        concatenation() : m_blocks(1) {}
+
+        template<typename S>
+        concatenation& append(const S& operand) {
+            auto source = __as_view(operand);
+
+            if constexpr (std::is_same_v<decltype(source), matrix_view<const T>>) {
+                m_blocks.back().push_back({source, npos});
+            } else {
+                m_owned.emplace_back(source);
+                m_blocks.back().push_back({m_owned.back().view(), m_owned.size() - 1});
+            }
+
+            return *this;
+        }
+
+        concatenation& next_row() {
+            m_blocks.emplace_back();
+            return *this;
+        }
+
+        size_t rows() const {
+            size_t result = 0;
+
+            for (const std::vector<piece>& row : m_blocks) {
+                result = result + (row.empty() ? 0 : __view(row[0]).rows());
+            }
+
+            return result;
+        }
+
+        size_t columns() const {
+            size_t result = 0;
+
+            for (const std::vector<piece>& row : m_blocks) {
+                if (!row.empty()) {
+                    for (const piece& block : row) {
+                        result = result + __view(block).columns();
+                    }
+
+                    break;
+                }
+            }
+
+            return result;
+        }
+
+        void build(const matrix_view<T>& output) const {
+#ifndef MATRIX_NOTHROW
+            if ((output.rows() != rows()) || (output.columns() != columns())) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            size_t top = 0;
+
+            for (const std::vector<piece>& row : m_blocks) {
+                if (row.empty()) {
+                    continue;
+                }
+
+                size_t height = __view(row[0]).rows();
+                size_t left = 0;
+                std::vector<matrix_view<const T>> sources;
+                std::vector<matrix_view<T>> targets;
+
+                for (const piece& block : row) {
+                    matrix_view<const T> source = __view(block);
+#ifndef MATRIX_NOTHROW
+                    if ((source.rows() != height) || (left + source.columns() > output.columns())) {
+                        throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                    }
+#endif
+                    sources.push_back(source);
+                    targets.push_back(output.block(top, left, height, source.columns()));
+                    left = left + source.columns();
+                }
+#ifndef MATRIX_NOTHROW
+                if (left != output.columns()) {
+                    throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                }
+#endif
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(static)
+#endif
+                for (long long index = 0; index < static_cast<long long>(height); index++) {
+                    for (size_t block = 0; block < sources.size(); block++) {
+                        __copy_row(sources[block], index, targets[block], index);
+                    }
+                }
+
+                top = top + height;
+            }
+        }
+
+        matrix<T> build() const {
+            matrix<T> result(rows(), columns());
+            build(result.view());
+            return result;
+        }
+    };
+
+    // Side by side: hstack(a, b, c) is [a b c].
+    template<typename First, typename... Rest>
+    auto hstack(const First& first, const Rest&... rest) {
+        using T = typename decltype(__as_view(first))::value_type;
+        concatenation<T> builder;
+        builder.append(first);
+        (builder.append(rest), ...);
+        matrix<T> result = builder.build();
+        return result;
+    }
+
+    // One above the other: vstack(a, b, c) is [a; b; c].
+    template<typename First, typename... Rest>
+    auto vstack(const First& first, const Rest&... rest) {
+        using T = typename decltype(__as_view(first))::value_type;
+        concatenation<T> builder;
+        builder.append(first);
+        ((builder.next_row(), builder.append(rest)), ...);
+        matrix<T> result = builder.build();
+        return result;
+    }
+
+    template<typename T>
+    auto __magnitude(const T& value) {
+        using std::abs;
+        auto result = abs(value);
+        return result;
+    }
+
+    // B = op(A)^-1 B through trsm for a triangular view above blas_threshold;
+    // a transposed view flips which triangle of the stored matrix is used.
+    template<typename TA, bool CA, typename T>
+    bool __blas_trsm(const matrix_view<TA, CA>& triangle, bool lower, bool unit, matrix<T>& operand) {
+        bool result = false;
+
+        if constexpr ((std::is_same_v<T, float> || std::is_same_v<T, double>) && std::is_same_v<std::remove_const_t<TA>, T>) {
+            auto trsm = __blas<T>().trsm;
+            int transpose, leading;
+
+            if ((trsm == nullptr) || (operand.rows() < blas_threshold) || !__blas_operand(triangle, transpose, leading)) {
+                return result;
+            }
+
+            int uplo = (lower == (transpose == 111)) ? 122 : 121;
+            trsm(101, 141, uplo, transpose, unit ? 132 : 131, operand.rows(), operand.columns(), T(1), triangle.data(), leading, operand.data(), operand.columns());
+            result = true;
+        }
+
+        return result;
+    }
+
+    // In-place B = L^-1 B and B = U^-1 B for triangular views; the inner loop
+    // runs over the contiguous right-hand sides.
+    template<typename TL, bool CL, typename T>
+    void __solve_lower(const matrix_view<TL, CL>& lower, bool unit, matrix<T>& operand) {
+        if (__blas_trsm(lower, true, unit, operand)) {
+            return;
+        }
+
+        size_t n = operand.rows();
+        size_t m = operand.columns();
+        T* data = operand.data();
+
+        for (size_t row = 0; row < n; row++) {
+            T* target = data + row * m;
+
+            for (size_t p = 0; p < row; p++) {
+                T factor = __element(lower, row, p);
+                const T* source = data + p * m;
+
+                if (factor == T()) { continue; }
+
+                for (size_t column = 0; column < m; column++) {
+                    target[column] = target[column] - factor * source[column];
+                }
+            }
+
+            if (!unit) {
+                T diagonal = __element(lower, row, row);
+
+                for (size_t column = 0; column < m; column++) {
+                    target[column] = target[column] / diagonal;
+                }
+            }
+        }
+    }
+
+    template<typename TU, bool CU, typename T>
+    void __solve_upper(const matrix_view<TU, CU>& upper, bool unit, matrix<T>& operand) {
+        if (__blas_trsm(upper, false, unit, operand)) {
+            return;
+        }
+
+        size_t n = operand.rows();
+        size_t m = operand.columns();
+        T* data = operand.data();
+
+        for (size_t row = n; row-- > 0;) {
+            T* target = data + row * m;
+
+            for (size_t p = row + 1; p < n; p++) {
+                T factor = __element(upper, row, p);
+                const T* source = data + p * m;
+
+                if (factor == T()) { continue; }
+
+                for (size_t column = 0; column < m; column++) {
+                    target[column] = target[column] - factor * source[column];
+                }
+            }
+
+            if (!unit) {
+                T diagonal = __element(upper, row, row);
+
+                for (size_t column = 0; column < m; column++) {
+                    target[column] = target[column] / diagonal;
+                }
+            }
+        }
+    }
+
+    // One right-looking step of blocked LU with partial pivoting: factors the
+    // panel of columns [k0, k0 + kb) of an m x n (m >= n) row-major view,
+    // swapping whole rows, then updates the trailing matrix through gemm.
+    template<typename T>
+    void __lu_step(const matrix_view<T>& a, size_t k0, size_t kb, std::vector<size_t>& pivots) {
+        size_t m = a.rows();
+        size_t n = a.columns();
+        size_t stride = a.row_stride();
+        T* data = a.data();
+
+        for (size_t j = k0; j < k0 + kb; j++) {
+            size_t pivot = j;
+
+            for (size_t row = j + 1; row < m; row++) {
+                if (__magnitude(data[row * stride + j]) > __magnitude(data[pivot * stride + j])) {
+                    pivot = row;
+                }
+            }
+#ifndef MATRIX_NOTHROW
+            if (data[pivot * stride + j] == T()) {
+                throw std::runtime_error(__error_messages[ERR_SINGULAR]);
+            }
+#endif
+            pivots[j] = pivot;
+
+            if (pivot != j) {
+                std::swap_ranges(data + j * stride, data + j * stride + n, data + pivot * stride);
+            }
+
+            for (size_t row = j + 1; row < m; row++) {
+                T& factor = data[row * stride + j];
+                factor = factor / data[j * stride + j];
+
+                for (size_t column = j + 1; column < k0 + kb; column++) {
+                    data[row * stride + column] = data[row * stride + column] - factor * data[j * stride + column];
+                }
+            }
+        }
+
+        for (size_t row = k0; row < k0 + kb; row++) {
+            for (size_t p = k0; p < row; p++) {
+                T factor = data[row * stride + p];
+
+                for (size_t column = k0 + kb; column < n; column++) {
+                    data[row * stride + column] = data[row * stride + column] - factor * data[p * stride + column];
+                }
+            }
+        }
+
+        if ((k0 + kb < m) && (k0 + kb < n)) {
+            gemm(T(-1), a.block(k0 + kb, k0, m - k0 - kb, kb), a.block(k0, k0 + kb, kb, n - k0 - kb), T(1), a.block(k0 + kb, k0 + kb, m - k0 - kb, n - k0 - kb));
+        }
+    }
+
+    // One step of blocked right-looking Cholesky (A = L * L^H, lower part
+    // only) on an n x m (n >= m) view, so tall panels can be factored alone.
+    template<typename T>
+    void __cholesky_step(const matrix_view<T>& a, size_t k0, size_t kb) {
+        size_t n = a.rows();
+        size_t m = a.columns();
+        size_t stride = a.row_stride();
+        T* data = a.data();
+
+        for (size_t j = k0; j < k0 + kb; j++) {
+            T diagonal = data[j * stride + j];
+
+            for (size_t p = k0; p < j; p++) {
+                diagonal = diagonal - data[j * stride + p] * __conjugate(data[j * stride + p]);
+            }
+#ifndef MATRIX_NOTHROW
+            if (!(std::real(diagonal) > 0)) {
+                throw std::runtime_error(__error_messages[ERR_NOT_POSITIVE_DEFINITE]);
+            }
+#endif
+            T pivot = T(std::sqrt(std::real(diagonal)));
+            data[j * stride + j] = pivot;
+
+            for (size_t row = j + 1; row < n; row++) {
+                T sum = data[row * stride + j];
+
+                for (size_t p = k0; p < j; p++) {
+                    sum = sum - data[row * stride + p] * __conjugate(data[j * stride + p]);
+                }
+
+                data[row * stride + j] = sum / pivot;
+            }
+        }
+
+        if (k0 + kb < m) {
+            matrix_view<T> panel = a.block(k0 + kb, k0, n - k0 - kb, kb);
+            gemm(T(-1), panel, a.block(k0 + kb, k0, m - k0 - kb, kb).h(), T(1), a.block(k0 + kb, k0 + kb, n - k0 - kb, m - k0 - kb));
+        }
+    }
+
+    template<typename T>
+    bool __lapack_getrf(matrix<T>& factors, std::vector<size_t>& pivots) {
+        bool result = false;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            const __blas_routines<T>& routines = __blas<T>();
+            int n = static_cast<int>(factors.rows());
+            std::vector<int> swaps(n);
+            int info = 0;
+
+            if ((factors.rows() < blas_threshold) || ((routines.getrf == nullptr) && (routines.fortran_getrf == nullptr))) {
+                return result;
+            }
+
+            if (routines.getrf != nullptr) {
+                info = routines.getrf(101, n, n, factors.data(), n, swaps.data());
+            } else {
+                // Fortran LAPACK is column-major: factor the transposed copy.
+                matrix<T> column_major = factors.transpose();
+                routines.fortran_getrf(&n, &n, column_major.data(), &n, swaps.data(), &info);
+                factors = column_major.transpose();
+            }
+#ifndef MATRIX_NOTHROW
+            if (info > 0) {
+                throw std::runtime_error(__error_messages[ERR_SINGULAR]);
+            }
+#endif
+            for (size_t index = 0; index < factors.rows(); index++) {
+                pivots[index] = static_cast<size_t>(swaps[index] - 1);
+            }
+
+            result = (info >= 0);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    bool __lapack_potrf(matrix<T>& factor) {
+        bool result = false;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            const __blas_routines<T>& routines = __blas<T>();
+            int n = static_cast<int>(factor.rows());
+            int info = 0;
+
+            if ((factor.rows() < blas_threshold) || ((routines.potrf == nullptr) && (routines.fortran_potrf == nullptr))) {
+                return result;
+            }
+
+            if (routines.potrf != nullptr) {
+                info = routines.potrf(101, 'L', n, factor.data(), n);
+            } else {
+                // Row-major lower is column-major upper of the same buffer.
+                char uplo = 'U';
+                routines.fortran_potrf(&uplo, &n, factor.data(), &n, &info);
+            }
+#ifndef MATRIX_NOTHROW
+            if (info > 0) {
+                throw std::runtime_error(__error_messages[ERR_NOT_POSITIVE_DEFINITE]);
+            }
+#endif
+            result = (info >= 0);
+        }
+
+        return result;
+    }
+
+    // B = A^-1 B from the row-major LU factors through LAPACKE getrs. Without
+    // it the solve still reaches the library through the trsm calls made by
+    // __solve_lower and __solve_upper.
+    template<typename T>
+    bool __lapack_getrs(const matrix<T>& factors, const std::vector<size_t>& pivots, matrix<T>& operand) {
+        bool result = false;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            auto getrs = __blas<T>().getrs;
+            int n = static_cast<int>(factors.rows());
+            int m = static_cast<int>(operand.columns());
+
+            if ((getrs == nullptr) || (factors.rows() < blas_threshold)) {
+                return result;
+            }
+
+            std::vector<int> swaps(n);
+
+            for (size_t index = 0; index < pivots.size(); index++) {
+                swaps[index] = static_cast<int>(pivots[index] + 1);
+            }
+
+            result = (getrs(101, 'N', n, m, factors.data(), n, swaps.data(), operand.data(), m) == 0);
+        }
+
+        return result;
+    }
+
+    template<typename T>
+    bool __lapack_potrs(const matrix<T>& factor, matrix<T>& operand) {
+        bool result = false;
+
+        if constexpr (std::is_same_v<T, float> || std::is_same_v<T, double>) {
+            auto potrs = __blas<T>().potrs;
+            int n = static_cast<int>(factor.rows());
+            int m = static_cast<int>(operand.columns());
+
+            if ((potrs == nullptr) || (factor.rows() < blas_threshold)) {
+                return result;
+            }
+
+            result = (potrs(101, 'L', n, m, factor.data(), n, operand.data(), m) == 0);
+        }
+
+        return result;
+    }
+
+    // Permutation of {0, ..., n - 1} held as its order: position i takes the
+    // original index order()[i]. As a matrix, P A has row i equal to row
+    // order()[i] of A and A P^T has column j equal to column order()[j].
+    class permutation {
+    private:
+        std::vector<size_t> m_order;
+
+        // Calls move(target, source) along each cycle of the order, with
+        // save(start) and restore(last) bracketing every nontrivial cycle.
+        template<typename S, typename M, typename R>
+        void __follow_cycles(S&& save, M&& move, R&& restore) const {
+            std::vector<bool> done(m_order.size());
+
+            for (size_t start = 0; start < m_order.size(); start++) {
+                if (done[start] || (m_order[start] == start)) {
+                    continue;
+                }
+
+                save(start);
+                size_t target = start;
+
+                while (m_order[target] != start) {
+                    move(target, m_order[target]);
+                    done[target] = true;
+                    target = m_order[target];
+                }
+
+                restore(target);
+                done[target] = true;
+            }
+        }
+
+    public:
+        permutation() {}
+
+        explicit permutation(size_t size) : m_order(size) {
+            for (size_t index = 0; index < size; index++) {
+                m_order[index] = index;
+            }
+        }
+
+        explicit permutation(std::vector<size_t> order) : m_order(std::move(order)) {
+#ifndef MATRIX_NOTHROW
+            std::vector<bool> seen(m_order.size());
+
+            for (size_t index : m_order) {
+                if ((index >= m_order.size()) || seen[index]) {
+                    throw std::runtime_error(__error_messages[ERR_PERMUTATION]);
+                }
+
+                seen[index] = true;
+            }
+#endif
+        }
+
+        // The permutation made by exchanging rows i and swaps[i] for
+        // i = 0, 1, ... in turn (LAPACK style pivots).
+        static permutation from_swaps(const std::vector<size_t>& swaps) {
+            permutation result(swaps.size());
+
+            for (size_t index = 0; index < swaps.size(); index++) {
+#ifndef MATRIX_NOTHROW
+                if (swaps[index] >= swaps.size()) {
+                    throw std::runtime_error(__error_messages[ERR_PERMUTATION]);
+                }
+#endif
+                std::swap(result.m_order[index], result.m_order[swaps[index]]);
+            }
+
+            return result;
+        }
+
+        size_t size() const {
+            size_t result = m_order.size();
+            return result;
+        }
+
+        const std::vector<size_t>& order() const {
+            const std::vector<size_t>& result = m_order;
+            return result;
+        }
+
+        size_t operator[](size_t index) const {
+            size_t result = m_order[index];
+            return result;
+        }
+
+        permutation inverse() const {
+            permutation result(m_order.size());
+
+            for (size_t index = 0; index < m_order.size(); index++) {
+                result.m_order[m_order[index]] = index;
+            }
+
+            return result;
+        }
+
+        // Matrix product P Q: applying the result equals applying Q, then P.
+        permutation operator*(const permutation& other) const {
+#ifndef MATRIX_NOTHROW
+            if (m_order.size() != other.m_order.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            permutation result(m_order.size());
+
+            for (size_t index = 0; index < m_order.size(); index++) {
+                result.m_order[index] = other.m_order[m_order[index]];
+            }
+
+            return result;
+        }
+
+        bool operator==(const permutation& other) const {
+            bool result = m_order == other.m_order;
+            return result;
+        }
+
+        bool operator!=(const permutation& other) const {
+            bool result = m_order != other.m_order;
+            return result;
+        }
+
+        // +1 or -1, the determinant of the permutation matrix.
+        int sign() const {
+            int result = 1;
+            __follow_cycles([](size_t) {}, [&](size_t, size_t) { result = -result; }, [](size_t) {});
+            return result;
+        }
+
+        template<typename T>
+        matrix<T> to_matrix() const {
+            matrix<T> result(m_order.size(), m_order.size());
+
+            for (size_t index = 0; index < m_order.size(); index++) {
+                result(index, m_order[index]) = T(1);
+            }
+
+            return result;
+        }
+
+        // x = P x in place, whole rows moving along each cycle with one row
+        // held aside.
+        template<typename T, size_t Rows, size_t Columns>
+        void apply_rows(matrix<T, Rows, Columns>& x) const {
+#ifndef MATRIX_NOTHROW
+            if (x.rows() != m_order.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            size_t width = x.columns();
+            std::vector<T> held(width);
+            T* data = x.data();
+            __follow_cycles(
+                [&](size_t start) { std::copy(data + start * width, data + (start + 1) * width, held.begin()); },
+                [&](size_t target, size_t source) { std::copy(data + source * width, data + (source + 1) * width, data + target * width); },
+                [&](size_t last) { std::copy(held.begin(), held.end(), data + last * width); });
+        }
+
+        // x = x P^T in place. Each contiguous row is gathered through a
+        // one-row buffer: independent loads instead of the dependent chain
+        // of an element-wise cycle walk.
+        template<typename T, size_t Rows, size_t Columns>
+        void apply_columns(matrix<T, Rows, Columns>& x) const {
+#ifndef MATRIX_NOTHROW
+            if (x.columns() != m_order.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            std::vector<T> held(x.columns());
+
+            for (size_t row = 0; row < x.rows(); row++) {
+                T* data = x.data() + row * x.columns();
+
+                for (size_t column = 0; column < x.columns(); column++) {
+                    held[column] = data[m_order[column]];
+                }
+
+                std::copy(held.begin(), held.end(), data);
+            }
+        }
+
+        // P A without forming P.
+        template<typename T, size_t Rows, size_t Columns>
+        matrix<T, Rows, Columns> operator*(const matrix<T, Rows, Columns>& operand) const {
+            matrix<T, Rows, Columns> result = operand;
+            apply_rows(result);
+            return result;
+        }
+    };
+
+    // P * A = L * U with unit lower L and upper U packed into one matrix;
+    // pivots[i] is the row swapped with row i at step i.
+    template<typename T>
+    class lu_factorization {
+    private:
+        matrix<T> m_factors;
+        std::vector<size_t> m_pivots;
+
+    public:
+        lu_factorization(matrix<T> factors, std::vector<size_t> pivots) {
+            m_factors = std::move(factors);
+            m_pivots = std::move(pivots);
+        }
+
+        const matrix<T>& factors() const {
+            const matrix<T>& result = m_factors;
+            return result;
+        }
+
+        const std::vector<size_t>& pivots() const {
+            const std::vector<size_t>& result = m_pivots;
+            return result;
+        }
+
+        // The P of P * A = L * U.
+        permutation row_permutation() const {
+            permutation result = permutation::from_swaps(m_pivots);
+            return result;
+        }
+
+        T determinant() const {
+            T result = T(1);
+
+            for (size_t index = 0; index < m_factors.rows(); index++) {
+                result = result * m_factors(index, index);
+
+                if (m_pivots[index] != index) {
+                    result = -result;
+                }
+            }
+
+            return result;
+        }
+
+        template<typename B>
+        matrix<T> solve(const B& operand) const {
+            auto b = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+            if (b.rows() != m_factors.rows()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            matrix<T> result(b);
+            size_t m = result.columns();
+
+            if (__lapack_getrs(m_factors, m_pivots, result)) {
+                return result;
+            }
+
+            for (size_t index = 0; index < m_pivots.size(); index++) {
+                if (m_pivots[index] != index) {
+                    std::swap_ranges(result.data() + index * m, result.data() + (index + 1) * m, result.data() + m_pivots[index] * m);
+                }
+            }
+
+            __solve_lower(m_factors.view(), true, result);
+            __solve_upper(m_factors.view(), false, result);
+            return result;
+        }
+    };
+
+    // A = L * L^H with L lower triangular.
+    template<typename T>
+    class cholesky_factorization {
+    private:
+        matrix<T> m_factor;
+
+    public:
+        cholesky_factorization(matrix<T> factor) {
+            m_factor = std::move(factor);
+        }
+
+        const matrix<T>& factor() const {
+            const matrix<T>& result = m_factor;
+            return result;
+        }
+
+        T determinant() const {
+            T result = T(1);
+
+            for (size_t index = 0; index < m_factor.rows(); index++) {
+                result = result * m_factor(index, index) * m_factor(index, index);
+            }
+
+            return result;
+        }
+
+        template<typename B>
+        matrix<T> solve(const B& operand) const {
+            auto b = __as_view(operand);
+#ifndef MATRIX_NOTHROW
+            if (b.rows() != m_factor.rows()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            matrix<T> result(b);
+
+            if (__lapack_potrs(m_factor, result)) {
+                return result;
+            }
+
+            __solve_lower(m_factor.view(), false, result);
+            __solve_upper(m_factor.h(), false, result);
+            return result;
+        }
+    };
+
+    // Binary matrix format: "MTRX", element size (uint32), rows and columns
+    // (uint64), then the row-major elements in native byte order.
+    template<typename T, size_t Rows, size_t Columns>
+    void write_binary(std::ostream& stream, const matrix<T, Rows, Columns>& operand) {
+        static_assert(std::is_trivially_copyable_v<T>, "binary matrix elements must be trivially copyable.");
+        uint32_t element_size = sizeof(T);
+        uint64_t extents[2] = {operand.rows(), operand.columns()};
+
+        stream.write("MTRX", 4);
+        stream.write(reinterpret_cast<const char*>(&element_size), sizeof(element_size));
+        stream.write(reinterpret_cast<const char*>(extents), sizeof(extents));
+        stream.write(reinterpret_cast<const char*>(operand.data()), operand.size() * sizeof(T));
+#ifndef MATRIX_NOTHROW
+        if (!stream) {
+            throw std::runtime_error(__error_messages[ERR_IO]);
+        }
+#endif
+    }
+
+    template<typename T>
+    matrix<T> read_binary(std::istream& stream) {
+        static_assert(std::is_trivially_copyable_v<T>, "binary matrix elements must be trivially copyable.");
+        char magic[4] = {};
+        uint32_t element_size = 0;
+        uint64_t extents[2] = {};
+        matrix<T> result;
+
+        stream.read(magic, 4);
+        stream.read(reinterpret_cast<char*>(&element_size), sizeof(element_size));
+        stream.read(reinterpret_cast<char*>(extents), sizeof(extents));
+#ifndef MATRIX_NOTHROW
+        if (!stream || !std::equal(magic, magic + 4, "MTRX") || (element_size != sizeof(T))) {
+            throw std::runtime_error(__error_messages[ERR_FORMAT]);
+        }
+#endif
+        if ((extents[0] > 0) && (extents[1] > 0)) {
+            result = matrix<T>(extents[0], extents[1]);
+            stream.read(reinterpret_cast<char*>(result.data()), result.size() * sizeof(T));
+        }
+#ifndef MATRIX_NOTHROW
+        if (!stream) {
+            throw std::runtime_error(__error_messages[ERR_FORMAT]);
+        }
+#endif
+        return result;
+    }
+
+    // Periodic on-disk snapshot of a long computation. Every `interval` steps
+    // the state is streamed once to a temporary file that then replaces the
+    // previous snapshot, so a preempted run always finds a complete one.
+    class checkpoint {
+    private:
+        std::string m_path;
+        size_t m_interval;
+
+    public:
+        checkpoint(std::string path, size_t interval = 1) {
+            m_path = std::move(path);
+            m_interval = std::max<size_t>(interval, 1);
+        }
+
+        const std::string& path() const {
+            const std::string& result = m_path;
+            return result;
+        }
+
+        bool due(size_t step) const {
+            bool result = (step % m_interval == 0);
+            return result;
+        }
+
+        template<typename L>
+        void save(L&& writer) const {
+            std::string temporary = m_path + ".tmp";
+
+            {
+                std::ofstream stream(temporary, std::ios::binary | std::ios::trunc);
+                writer(static_cast<std::ostream&>(stream));
+                stream.flush();
+#ifndef MATRIX_NOTHROW
+                if (!stream) {
+                    throw std::runtime_error(__error_messages[ERR_IO]);
+                }
+#endif
+            }
+#ifndef MATRIX_NOTHROW
+            if (std::rename(temporary.c_str(), m_path.c_str()) != 0) {
+                throw std::runtime_error(__error_messages[ERR_IO]);
+            }
+#else
+            std::rename(temporary.c_str(), m_path.c_str());
+#endif
+        }
+
+        // Returns false when there is no snapshot to resume from.
+        template<typename L>
+        bool restore(L&& reader) const {
+            std::ifstream stream(m_path, std::ios::binary);
+
+            if (!stream) {
+                return false;
+            }
+
+            reader(static_cast<std::istream&>(stream));
+            return true;
+        }
+
+        void clear() const {
+            std::remove(m_path.c_str());
+        }
     };
+
+    inline void __write_index(std::ostream& stream, size_t value) {
+        matrix<uint64_t, 1, 1> index = {value};
+        write_binary(stream, index);
+    }
+
+    inline size_t __read_index(std::istream& stream) {
+        matrix<uint64_t> index = read_binary<uint64_t>(stream);
+#ifndef MATRIX_NOTHROW
+        if (index.size() != 1) {
+            throw std::runtime_error(__error_messages[ERR_CHECKPOINT]);
+        }
+#endif
+        size_t result = index.data()[0];
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns>
+    lu_factorization<T> lu(const matrix<T, Rows, Columns>& operand) {
+        static_assert(__compatible_extent(Rows, Columns), "matrix must be square [rows = columns].");
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        constexpr size_t block = 64;
+        matrix<T> factors(operand);
+        std::vector<size_t> pivots(factors.rows());
+
+        if (!__lapack_getrf(factors, pivots)) {
+            for (size_t k0 = 0; k0 < factors.rows(); k0 += block) {
+                __lu_step(factors.view(), k0, std::min(block, factors.rows() - k0), pivots);
+            }
+        }
+
+        lu_factorization<T> result(std::move(factors), std::move(pivots));
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns>
+    cholesky_factorization<T> cholesky(const matrix<T, Rows, Columns>& operand) {
+        static_assert(__compatible_extent(Rows, Columns), "matrix must be square [rows = columns].");
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        constexpr size_t block = 64;
+        matrix<T> factor(operand);
+
+        if (!__lapack_potrf(factor)) {
+            for (size_t k0 = 0; k0 < factor.rows(); k0 += block) {
+                __cholesky_step(factor.view(), k0, std::min(block, factor.rows() - k0));
+            }
+        }
+
+        for (size_t row = 0; row < factor.rows(); row++) {
+            for (size_t column = row + 1; column < factor.columns(); column++) {
+                factor(row, column) = T();
+            }
+        }
+
+        cholesky_factorization<T> result(std::move(factor));
+        return result;
+    }
+
+    // LU that snapshots the partially factored matrix, the pivots so far and
+    // the next panel through `state`, and resumes from an existing snapshot.
+    // The snapshot is removed once the factorization completes.
+    template<typename T, size_t Rows, size_t Columns>
+    lu_factorization<T> lu(const matrix<T, Rows, Columns>& operand, const checkpoint& state) {
+        static_assert(__compatible_extent(Rows, Columns), "matrix must be square [rows = columns].");
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        constexpr size_t block = 64;
+        size_t n = operand.rows();
+        size_t start = 0;
+        matrix<T> factors(operand);
+        std::vector<size_t> pivots(n);
+
+        state.restore([&](std::istream& stream) {
+            start = __read_index(stream);
+            factors = read_binary<T>(stream);
+            matrix<uint64_t> saved = read_binary<uint64_t>(stream);
+#ifndef MATRIX_NOTHROW
+            if ((factors.rows() != n) || (factors.columns() != n) || (saved.size() != n) || (start > n)) {
+                throw std::runtime_error(__error_messages[ERR_CHECKPOINT]);
+            }
+#endif
+            std::copy(saved.data(), saved.data() + n, pivots.begin());
+        });
+
+        for (size_t k0 = start; k0 < n; k0 += block) {
+            __lu_step(factors.view(), k0, std::min(block, n - k0), pivots);
+
+            if ((k0 + block < n) && state.due(k0 / block + 1)) {
+                state.save([&](std::ostream& stream) {
+                    matrix<uint64_t> saved(n, 1);
+                    std::copy(pivots.begin(), pivots.end(), saved.data());
+                    __write_index(stream, k0 + block);
+                    write_binary(stream, factors);
+                    write_binary(stream, saved);
+                });
+            }
+        }
+
+        state.clear();
+        lu_factorization<T> result(std::move(factors), std::move(pivots));
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns>
+    cholesky_factorization<T> cholesky(const matrix<T, Rows, Columns>& operand, const checkpoint& state) {
+        static_assert(__compatible_extent(Rows, Columns), "matrix must be square [rows = columns].");
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        constexpr size_t block = 64;
+        size_t n = operand.rows();
+        size_t start = 0;
+        matrix<T> factor(operand);
+
+        state.restore([&](std::istream& stream) {
+            start = __read_index(stream);
+            factor = read_binary<T>(stream);
+#ifndef MATRIX_NOTHROW
+            if ((factor.rows() != n) || (factor.columns() != n) || (start > n)) {
+                throw std::runtime_error(__error_messages[ERR_CHECKPOINT]);
+            }
+#endif
+        });
+
+        for (size_t k0 = start; k0 < n; k0 += block) {
+            __cholesky_step(factor.view(), k0, std::min(block, n - k0));
+
+            if ((k0 + block < n) && state.due(k0 / block + 1)) {
+                state.save([&](std::ostream& stream) {
+                    __write_index(stream, k0 + block);
+                    write_binary(stream, factor);
+                });
+            }
+        }
+
+        for (size_t row = 0; row < n; row++) {
+            for (size_t column = row + 1; column < n; column++) {
+                factor(row, column) = T();
+            }
+        }
+
+        state.clear();
+        cholesky_factorization<T> result(std::move(factor));
+        return result;
+    }
+
+    template<typename T, size_t Rows, size_t Columns, typename B>
+    matrix<T> solve(const matrix<T, Rows, Columns>& operand, const B& right) {
+        matrix<T> result = lu(operand).solve(right);
+        return result;
+    }
 }
 
 #endif
\ No newline at end of file
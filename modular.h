@@ -0,0 +1,511 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_MODULAR_H
+#define MATRIX_MODULAR_H
+
+#include "matrix.h"
+
+namespace matrix {
+    inline uint32_t __power_mod(uint32_t base, uint64_t exponent, uint32_t p) {
+        uint64_t result = 1 % p;
+        uint64_t square = base % p;
+
+        while (exponent > 0) {
+            if (exponent & 1) {
+                result = result * square % p;
+            }
+
+            square = square * square % p;
+            exponent = exponent >> 1;
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
+    // Element of Z/PZ for a prime P < 2^31, stored as its least residue.
+    // Division uses Fermat inversion, so P must be prime.
+    template<uint32_t P>
+    class modular {
+        static_assert((P > 1) && (P < (uint32_t(1) << 31)), "modulus must be in [2, 2^31).");
+
+    private:
+        uint32_t m_value;
+
+    public:
+        constexpr modular() : m_value(0) {}
+
+        constexpr modular(long long value) : m_value(static_cast<uint32_t>(((value % static_cast<long long>(P)) + static_cast<long long>(P)) % static_cast<long long>(P))) {}
+
+        static constexpr uint32_t modulus() {
+            return P;
+        }
+
+        constexpr uint32_t value() const {
+            uint32_t result = m_value;
+            return result;
+        }
+
+        constexpr modular operator+(const modular& other) const {
+            uint32_t sum = m_value + other.m_value;
+            modular result;
+            result.m_value = (sum >= P) ? sum - P : sum;
+            return result;
+        }
+
+        constexpr modular operator-(const modular& other) const {
+            modular result;
+            result.m_value = (m_value >= other.m_value) ? m_value - other.m_value : m_value + P - other.m_value;
+            return result;
+        }
+
+        constexpr modular operator-() const {
+            modular result;
+            result.m_value = (m_value == 0) ? 0 : P - m_value;
+            return result;
+        }
+
+        constexpr modular operator*(const modular& other) const {
+            modular result;
+            result.m_value = static_cast<uint32_t>(uint64_t(m_value) * other.m_value % P);
+            return result;
+        }
+
+        modular inverse() const {
+#ifndef MATRIX_NOTHROW
+            if (m_value == 0) {
+                throw std::runtime_error(__error_messages[ERR_SINGULAR]);
+            }
+#endif
+            modular result;
+            result.m_value = __power_mod(m_value, P - 2, P);
+            return result;
+        }
+
+        modular operator/(const modular& other) const {
+            modular result = (*this) * other.inverse();
+            return result;
+        }
+
+        constexpr bool operator==(const modular& other) const {
+            bool result = m_value == other.m_value;
+            return result;
+        }
+
+        constexpr bool operator!=(const modular& other) const {
+            bool result = m_value != other.m_value;
+            return result;
+        }
+    };
+
+    // Pivoting only needs a nonzero element; the residue serves as magnitude.
+    template<uint32_t P>
+    constexpr uint32_t abs(const modular<P>& value) {
+        uint32_t result = value.value();
+        return result;
+    }
+
+    template<uint32_t P>
+    std::ostream& operator<<(std::ostream& stream, const modular<P>& value) {
+        stream << value.value();
+        return stream;
+    }
+
+    // result = (result + A B) mod p for integer-valued double matrices whose
+    // products are at most `bound` in magnitude. Chunks of 2^53 / bound
+    // terms sum exactly in double precision, so each chunk is one floating
+    // point GEMM followed by a single reduction per element (delayed
+    // reduction).
+    inline void __modular_accumulate(const matrix<double>& a, const matrix<double>& b, uint32_t p, double bound, matrix<uint64_t>& result) {
+        size_t m = a.rows();
+        size_t n = b.columns();
+        size_t k = a.columns();
+        size_t chunk = std::max<size_t>(1, static_cast<size_t>(9007199254740992.0 / std::max(bound, 1.0)));
+        matrix<double> partial(m, n);
+
+        for (size_t k0 = 0; k0 < k; k0 += chunk) {
+            size_t kc = std::min(chunk, k - k0);
+            gemm(1.0, a.block(0, k0, m, kc), b.block(k0, 0, kc, n), 0.0, partial.view());
+
+            for (size_t i = 0; i < m; i++) {
+                for (size_t j = 0; j < n; j++) {
+                    int64_t value = static_cast<int64_t>(partial(i, j)) % static_cast<int64_t>(p);
+                    result(i, j) = (result(i, j) + static_cast<uint64_t>((value < 0) ? value + p : value)) % p;
+                }
+            }
+        }
+    }
+
+    // Splits centred residues as x = high 2^15 + low with |high| <= 2^15 and
+    // |low| <= 2^14.
+    inline void __split_residues(const matrix<double>& x, matrix<double>& high, matrix<double>& low) {
+        high = matrix<double>(x.rows(), x.columns());
+        low = matrix<double>(x.rows(), x.columns());
+
+        for (size_t row = 0; row < x.rows(); row++) {
+            for (size_t column = 0; column < x.columns(); column++) {
+                double top = std::floor(x(row, column) / 32768.0 + 0.5);
+                high(row, column) = top;
+                low(row, column) = x(row, column) - top * 32768.0;
+            }
+        }
+    }
+
+    // C = A B mod p for matrices of centred residues (|x| <= (p - 1) / 2)
+    // held in doubles. Up to p = 2^26 the residues multiply directly, in
+    // chunks of at least eight terms. Larger primes (up to 2^31) would leave
+    // chunks of only a few terms, so the operands are split into 15-bit
+    // halves and the product is assembled as
+    // A_h B_h 2^30 + (A_h B_l + A_l B_h) 2^15 + A_l B_l; each partial product
+    // is bounded by 2^30 and keeps chunks of 2^23 terms.
+    inline matrix<uint64_t> __modular_product(const matrix<double>& a, const matrix<double>& b, uint32_t p) {
+        size_t m = a.rows();
+        size_t n = b.columns();
+        matrix<uint64_t> result(m, n);
+
+        if (p <= (uint32_t(1) << 26)) {
+            __modular_accumulate(a, b, p, double(p / 2) * double(p / 2), result);
+            return result;
+        }
+
+        double bound = 1073741824.0;
+        matrix<double> a_high;
+        matrix<double> a_low;
+        matrix<double> b_high;
+        matrix<double> b_low;
+        matrix<uint64_t> middle(m, n);
+        matrix<uint64_t> low(m, n);
+        __split_residues(a, a_high, a_low);
+        __split_residues(b, b_high, b_low);
+        __modular_accumulate(a_high, b_high, p, bound, result);
+        __modular_accumulate(a_high, b_low, p, bound, middle);
+        __modular_accumulate(a_low, b_high, p, bound, middle);
+        __modular_accumulate(a_low, b_low, p, bound, low);
+        uint64_t shift = (uint64_t(1) << 30) % p;
+
+        for (size_t i = 0; i < m; i++) {
+            for (size_t j = 0; j < n; j++) {
+                result(i, j) = (result(i, j) * shift + (middle(i, j) << 15) + low(i, j)) % p;
+            }
+        }
+
+        return result;
+    }
+
+    // GEMM over Z/PZ, picked up by argument-dependent lookup for matrices
+    // and views of modular<P>, so operator* and the blocked LU use the
+    // delayed-reduction kernel.
+    template<uint32_t P, typename TA, bool CA, typename TB, bool CB, std::enable_if_t<std::is_same_v<std::remove_const_t<TA>, modular<P>> && std::is_same_v<std::remove_const_t<TB>, modular<P>>, int> = 0>
+    void gemm(modular<P> alpha, const matrix_view<TA, CA>& a, const matrix_view<TB, CB>& b, modular<P> beta, const matrix_view<modular<P>>& c) {
+#ifndef MATRIX_NOTHROW
+        if ((a.columns() != b.rows()) || (a.rows() != c.rows()) || (b.columns() != c.columns())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        if ((c.rows() == 0) || (c.columns() == 0)) {
+            return;
+        }
+
+        if (a.columns() == 0) {
+            for (size_t row = 0; row < c.rows(); row++) {
+                for (size_t column = 0; column < c.columns(); column++) {
+                    c(row, column) = beta * c(row, column);
+                }
+            }
+
+            return;
+        }
+
+        matrix<double> x(a.rows(), a.columns());
+        matrix<double> y(b.rows(), b.columns());
+        auto centre = [](const modular<P>& value) {
+            double result = (value.value() > P / 2) ? double(value.value()) - double(P) : double(value.value());
+            return result;
+        };
+
+        x.transform([&](size_t row, size_t column, double& value) { value = centre(a(row, column)); });
+        y.transform([&](size_t row, size_t column, double& value) { value = centre(b(row, column)); });
+        matrix<uint64_t> product = __modular_product(x, y, P);
+
+        for (size_t row = 0; row < c.rows(); row++) {
+            for (size_t column = 0; column < c.columns(); column++) {
+                modular<P> value(static_cast<long long>(product(row, column)));
+                c(row, column) = alpha * value + ((beta == modular<P>()) ? modular<P>() : beta * c(row, column));
+            }
+        }
+    }
+
+    // Row echelon form of a row-major residue array, in place. Returns the
+    // rank; `determinant` receives the product of the pivots with the sign
+    // of the row permutation (meaningful for square inputs).
+    inline size_t __modular_echelon(std::vector<uint32_t>& data, size_t rows, size_t columns, uint32_t p, uint32_t& determinant) {
+        size_t rank = 0;
+        uint64_t product = 1 % p;
+        bool negate = false;
+
+        for (size_t column = 0; (column < columns) && (rank < rows); column++) {
+            size_t pivot = rank;
+
+            while ((pivot < rows) && (data[pivot * columns + column] == 0)) {
+                pivot++;
+            }
+
+            if (pivot == rows) {
+                product = 0;
+                continue;
+            }
+
+            if (pivot != rank) {
+                std::swap_ranges(data.begin() + pivot * columns, data.begin() + (pivot + 1) * columns, data.begin() + rank * columns);
+                negate = !negate;
+            }
+
+            uint32_t* top = data.data() + rank * columns;
+            product = product * top[column] % p;
+            uint64_t inverse = __power_mod(top[column], p - 2, p);
+
+            for (size_t row = rank + 1; row < rows; row++) {
+                uint32_t* target = data.data() + row * columns;
+
+                if (target[column] == 0) {
+                    continue;
+                }
+
+                uint64_t factor = (p - target[column] * inverse % p) % p;
+
+                for (size_t j = column; j < columns; j++) {
+                    target[j] = static_cast<uint32_t>((target[j] + factor * top[j]) % p);
+                }
+            }
+
+            rank++;
+        }
+
+        if (rank < std::min(rows, columns)) {
+            product = 0;
+        }
+
+        determinant = static_cast<uint32_t>((negate && (product != 0)) ? p - product : product);
+        return rank;
+    }
+
+    template<uint32_t P, size_t Rows, size_t Columns>
+    std::vector<uint32_t> __residues(const matrix<modular<P>, Rows, Columns>& operand) {
+        std::vector<uint32_t> result(operand.rows() * operand.columns());
+
+        for (size_t row = 0; row < operand.rows(); row++) {
+            for (size_t column = 0; column < operand.columns(); column++) {
+                result[row * operand.columns() + column] = operand(row, column).value();
+            }
+        }
+
+        return result;
+    }
+
+    template<uint32_t P, size_t Rows, size_t Columns>
+    size_t rank(const matrix<modular<P>, Rows, Columns>& operand) {
+        std::vector<uint32_t> data = __residues(operand);
+        uint32_t determinant;
+        size_t result = __modular_echelon(data, operand.rows(), operand.columns(), P, determinant);
+        return result;
+    }
+
+    // Exact determinant over Z/PZ, zero for singular matrices. Nonsingular
+    // systems are solved exactly with solve(a, b) / lu(a), whose trailing
+    // updates run through the modular GEMM.
+    template<uint32_t P, size_t Rows, size_t Columns>
+    modular<P> determinant(const matrix<modular<P>, Rows, Columns>& operand) {
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        std::vector<uint32_t> data = __residues(operand);
+        uint32_t value;
+        __modular_echelon(data, operand.rows(), operand.columns(), P, value);
+        modular<P> result(static_cast<long long>(value));
+        return result;
+    }
+
+    // Little-endian base 2^32 naturals for the Chinese remainder step.
+    inline uint32_t __big_mod(const std::vector<uint32_t>& x, uint32_t p) {
+        uint64_t result = 0;
+
+        for (size_t index = x.size(); index-- > 0;) {
+            result = ((result << 32) | x[index]) % p;
+        }
+
+        return static_cast<uint32_t>(result);
+    }
+
+    inline std::vector<uint32_t> __big_multiply(const std::vector<uint32_t>& x, uint32_t factor) {
+        std::vector<uint32_t> result;
+        uint64_t carry = 0;
+
+        for (uint32_t limb : x) {
+            uint64_t value = uint64_t(limb) * factor + carry;
+            result.push_back(static_cast<uint32_t>(value));
+            carry = value >> 32;
+        }
+
+        if (carry != 0) {
+            result.push_back(static_cast<uint32_t>(carry));
+        }
+
+        return result;
+    }
+
+    inline void __big_add(std::vector<uint32_t>& x, const std::vector<uint32_t>& y) {
+        uint64_t carry = 0;
+        x.resize(std::max(x.size(), y.size()));
+
+        for (size_t index = 0; index < x.size(); index++) {
+            uint64_t value = uint64_t(x[index]) + ((index < y.size()) ? y[index] : 0) + carry;
+            x[index] = static_cast<uint32_t>(value);
+            carry = value >> 32;
+        }
+
+        if (carry != 0) {
+            x.push_back(static_cast<uint32_t>(carry));
+        }
+    }
+
+    // x - y for x >= y.
+    inline std::vector<uint32_t> __big_subtract(const std::vector<uint32_t>& x, const std::vector<uint32_t>& y) {
+        std::vector<uint32_t> result(x.size());
+        int64_t borrow = 0;
+
+        for (size_t index = 0; index < x.size(); index++) {
+            int64_t value = int64_t(x[index]) - ((index < y.size()) ? int64_t(y[index]) : 0) - borrow;
+            borrow = (value < 0) ? 1 : 0;
+            result[index] = static_cast<uint32_t>(value + (borrow << 32));
+        }
+
+        while (!result.empty() && (result.back() == 0)) {
+            result.pop_back();
+        }
+
+        return result;
+    }
+
+    inline std::string __big_to_string(std::vector<uint32_t> x) {
+        std::string result;
+
+        while (!x.empty()) {
+            uint64_t remainder = 0;
+
+            for (size_t index = x.size(); index-- > 0;) {
+                uint64_t value = (remainder << 32) | x[index];
+                x[index] = static_cast<uint32_t>(value / 1000000000);
+                remainder = value % 1000000000;
+            }
+
+            while (!x.empty() && (x.back() == 0)) {
+                x.pop_back();
+            }
+
+            std::string digits = std::to_string(remainder);
+
+            if (!x.empty()) {
+                digits = std::string(9 - digits.size(), '0') + digits;
+            }
+
+            result = digits + result;
+        }
+
+        return result.empty() ? "0" : result;
+    }
+
+    // Exact determinant of an integer matrix, in decimal. The determinant is
+    // taken modulo primes just below 2^26 until their product exceeds twice
+    // the Hadamard bound, and the residues are combined by incremental
+    // Chinese remaindering into the symmetric range.
+    template<typename T, size_t Rows, size_t Columns>
+    std::string exact_determinant(const matrix<T, Rows, Columns>& operand) {
+        static_assert(std::is_integral_v<T>, "exact determinants need an integer matrix.");
+#ifndef MATRIX_NOTHROW
+        if (operand.rows() != operand.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        size_t n = operand.rows();
+        double bits = 1;
+
+        for (size_t row = 0; row < n; row++) {
+            double sum = 0;
+
+            for (size_t column = 0; column < n; column++) {
+                sum = sum + double(operand(row, column)) * double(operand(row, column));
+            }
+
+            if (sum == 0) {
+                return "0";
+            }
+
+            bits = bits + 0.5 * std::log2(sum);
+        }
+
+        std::vector<uint32_t> value;
+        std::vector<uint32_t> modulus = {1};
+        double covered = 0;
+
+        for (uint32_t p = (uint32_t(1) << 26) - 1; covered <= bits; p -= 2) {
+            bool prime = true;
+
+            for (uint32_t d = 3; (d * d <= p) && prime; d += 2) {
+                prime = (p % d) != 0;
+            }
+
+            if (!prime) {
+                continue;
+            }
+
+            std::vector<uint32_t> data(n * n);
+
+            for (size_t index = 0; index < n * n; index++) {
+                long long element = static_cast<long long>(operand(index / n, index % n)) % static_cast<long long>(p);
+                data[index] = static_cast<uint32_t>((element < 0) ? element + p : element);
+            }
+
+            uint32_t residue;
+            __modular_echelon(data, n, n, p, residue);
+            uint64_t difference = (uint64_t(residue) + p - __big_mod(value, p)) % p;
+            uint64_t step = difference * __power_mod(__big_mod(modulus, p), p - 2, p) % p;
+            __big_add(value, __big_multiply(modulus, static_cast<uint32_t>(step)));
+            modulus = __big_multiply(modulus, p);
+            covered = covered + std::log2(double(p));
+        }
+
+        while (!value.empty() && (value.back() == 0)) {
+            value.pop_back();
+        }
+
+        std::vector<uint32_t> twice = __big_multiply(value, 2);
+        bool negative = (twice.size() > modulus.size()) || ((twice.size() == modulus.size()) && std::lexicographical_compare(modulus.rbegin(), modulus.rend(), twice.rbegin(), twice.rend()));
+
+        std::string result = negative ? "-" + __big_to_string(__big_subtract(modulus, value)) : __big_to_string(value);
+        return result;
+    }
+}
+
+#endif
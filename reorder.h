@@ -0,0 +1,341 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_REORDER_H
+#define MATRIX_REORDER_H
+
+#include "sparse.h"
+
+namespace matrix {
+    // Pattern of A + A^T without the diagonal: the undirected graph both
+    // orderings work on.
+    template<typename T>
+    csr_matrix<char> __adjacency(const csr_matrix<T>& a) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        std::vector<size_t> rows;
+        std::vector<size_t> columns;
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t index = a.offsets()[row]; index < a.offsets()[row + 1]; index++) {
+                if (a.indices()[index] != row) {
+                    rows.push_back(row);
+                    columns.push_back(a.indices()[index]);
+                    rows.push_back(a.indices()[index]);
+                    columns.push_back(row);
+                }
+            }
+        }
+
+        std::vector<char> ones(rows.size(), 1);
+        csr_matrix<char> result = csr_matrix<char>::from_triplets(a.rows(), a.columns(), rows, columns, ones);
+        return result;
+    }
+
+    // Breadth-first level structure from `root` over the vertices carrying
+    // `label`. Returns the vertices in visiting order and leaves their depths
+    // in `level`, which the caller resets to SIZE_MAX afterwards.
+    inline std::vector<size_t> __level_structure(const csr_matrix<char>& g, size_t root, const std::vector<size_t>& labels, size_t label, std::vector<size_t>& level) {
+        std::vector<size_t> result = {root};
+        level[root] = 0;
+
+        for (size_t head = 0; head < result.size(); head++) {
+            size_t vertex = result[head];
+
+            for (size_t index = g.offsets()[vertex]; index < g.offsets()[vertex + 1]; index++) {
+                size_t neighbor = g.indices()[index];
+
+                if ((labels[neighbor] == label) && (level[neighbor] == std::numeric_limits<size_t>::max())) {
+                    level[neighbor] = level[vertex] + 1;
+                    result.push_back(neighbor);
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // George-Liu pseudo-peripheral vertex: restart from a minimum degree
+    // vertex of the deepest level until the eccentricity stops growing.
+    inline size_t __pseudo_peripheral(const csr_matrix<char>& g, size_t start, const std::vector<size_t>& labels, size_t label, std::vector<size_t>& level) {
+        // Depth of the level structure from `root` and a minimum degree
+        // vertex of its deepest level.
+        auto probe = [&](size_t root, size_t& candidate) {
+            std::vector<size_t> visited = __level_structure(g, root, labels, label, level);
+            size_t depth = level[visited.back()];
+            candidate = visited.back();
+
+            for (size_t index = visited.size(); (index-- > 0) && (level[visited[index]] == depth);) {
+                size_t vertex = visited[index];
+
+                if ((g.offsets()[vertex + 1] - g.offsets()[vertex]) < (g.offsets()[candidate + 1] - g.offsets()[candidate])) {
+                    candidate = vertex;
+                }
+            }
+
+            for (size_t vertex : visited) {
+                level[vertex] = std::numeric_limits<size_t>::max();
+            }
+
+            return depth;
+        };
+
+        size_t result = start;
+        size_t candidate;
+        size_t eccentricity = probe(result, candidate);
+
+        while (eccentricity > 0) {
+            size_t next;
+            size_t depth = probe(candidate, next);
+
+            if (depth <= eccentricity) {
+                break;
+            }
+
+            result = candidate;
+            eccentricity = depth;
+            candidate = next;
+        }
+
+        return result;
+    }
+
+    // Reverse Cuthill-McKee ordering of the symmetrized pattern. Each
+    // connected component is traversed breadth first from a
+    // pseudo-peripheral vertex, neighbors in increasing degree, and the
+    // sequence is reversed. Applied with permute(), the permutation
+    // clusters the nonzeros near the diagonal.
+    template<typename T>
+    permutation reverse_cuthill_mckee(const csr_matrix<T>& a) {
+        csr_matrix<char> g = __adjacency(a);
+        size_t n = g.rows();
+        std::vector<size_t> labels(n);
+        std::vector<size_t> level(n, std::numeric_limits<size_t>::max());
+        std::vector<bool> visited(n);
+        std::vector<size_t> degree(n);
+        std::vector<size_t> starts(n);
+        std::vector<size_t> order;
+        order.reserve(n);
+
+        for (size_t vertex = 0; vertex < n; vertex++) {
+            degree[vertex] = g.offsets()[vertex + 1] - g.offsets()[vertex];
+            starts[vertex] = vertex;
+        }
+
+        std::stable_sort(starts.begin(), starts.end(), [&](size_t x, size_t y) {
+            return degree[x] < degree[y];
+        });
+
+        for (size_t start : starts) {
+            if (visited[start]) {
+                continue;
+            }
+
+            size_t root = __pseudo_peripheral(g, start, labels, 0, level);
+            visited[root] = true;
+            order.push_back(root);
+
+            for (size_t head = order.size() - 1; head < order.size(); head++) {
+                size_t vertex = order[head];
+                size_t first = order.size();
+
+                for (size_t index = g.offsets()[vertex]; index < g.offsets()[vertex + 1]; index++) {
+                    size_t neighbor = g.indices()[index];
+
+                    if (!visited[neighbor]) {
+                        visited[neighbor] = true;
+                        order.push_back(neighbor);
+                    }
+                }
+
+                std::stable_sort(order.begin() + first, order.end(), [&](size_t x, size_t y) {
+                    return degree[x] < degree[y];
+                });
+            }
+        }
+
+        std::reverse(order.begin(), order.end());
+        permutation result(std::move(order));
+        return result;
+    }
+
+    // Largest |i - j| over the entries of a.
+    template<typename T>
+    size_t bandwidth(const csr_matrix<T>& a) {
+        size_t result = 0;
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t index = a.offsets()[row]; index < a.offsets()[row + 1]; index++) {
+                size_t column = a.indices()[index];
+                result = std::max(result, (column > row) ? column - row : row - column);
+            }
+        }
+
+        return result;
+    }
+
+    // Part p holds the original indices order[offsets[p] .. offsets[p + 1]).
+    struct partition_result {
+        permutation order;
+        std::vector<size_t> offsets;
+    };
+
+    // Splits `vertices` (all labelled alike) into parts / 2 and the
+    // remaining parts proportionally, then recurses into both halves. The
+    // first half is grown breadth first from a pseudo-peripheral vertex;
+    // boundary vertices whose move cuts fewer edges are then moved across
+    // greedily while the halves stay within 2% of their target sizes.
+    inline void __bisect(const csr_matrix<char>& g, const std::vector<size_t>& vertices, size_t parts, std::vector<size_t>& labels, size_t& next_label, std::vector<size_t>& level, std::vector<size_t>& order, std::vector<size_t>& offsets) {
+        if (vertices.empty() || (parts == 1)) {
+            order.insert(order.end(), vertices.begin(), vertices.end());
+
+            for (size_t part = 0; part < parts; part++) {
+                offsets.push_back(order.size());
+            }
+
+            return;
+        }
+
+        size_t label = labels[vertices[0]];
+        size_t left_parts = parts / 2;
+        size_t target = (vertices.size() * left_parts + parts / 2) / parts;
+        size_t left = next_label++;
+        size_t right = next_label++;
+        size_t grown = 0;
+
+        for (size_t seed = 0; grown < target; seed++) {
+            if (labels[vertices[seed]] != label) {
+                continue;
+            }
+
+            size_t root = __pseudo_peripheral(g, vertices[seed], labels, label, level);
+            std::vector<size_t> queue = {root};
+            labels[root] = left;
+            grown++;
+
+            for (size_t head = 0; (head < queue.size()) && (grown < target); head++) {
+                size_t vertex = queue[head];
+
+                for (size_t index = g.offsets()[vertex]; (index < g.offsets()[vertex + 1]) && (grown < target); index++) {
+                    size_t neighbor = g.indices()[index];
+
+                    if (labels[neighbor] == label) {
+                        labels[neighbor] = left;
+                        queue.push_back(neighbor);
+                        grown++;
+                    }
+                }
+            }
+        }
+
+        for (size_t vertex : vertices) {
+            if (labels[vertex] == label) {
+                labels[vertex] = right;
+            }
+        }
+
+        size_t slack = vertices.size() / 50;
+        size_t low = (target > slack) ? target - slack : 0;
+        size_t high = std::min(vertices.size(), target + slack);
+
+        for (size_t pass = 0; pass < 8; pass++) {
+            bool moved = false;
+
+            for (size_t vertex : vertices) {
+                size_t side = labels[vertex];
+                size_t other = (side == left) ? right : left;
+                long long gain = 0;
+
+                for (size_t index = g.offsets()[vertex]; index < g.offsets()[vertex + 1]; index++) {
+                    size_t neighbor = labels[g.indices()[index]];
+                    gain = gain + ((neighbor == other) ? 1 : 0) - ((neighbor == side) ? 1 : 0);
+                }
+
+                bool balanced = (side == left) ? (grown > low) : (grown < high);
+
+                if ((gain > 0) && balanced) {
+                    labels[vertex] = other;
+                    grown = (side == left) ? grown - 1 : grown + 1;
+                    moved = true;
+                }
+            }
+
+            if (!moved) {
+                break;
+            }
+        }
+
+        std::vector<size_t> first;
+        std::vector<size_t> second;
+
+        for (size_t vertex : vertices) {
+            if (labels[vertex] == left) {
+                first.push_back(vertex);
+            } else {
+                second.push_back(vertex);
+            }
+        }
+
+        __bisect(g, first, left_parts, labels, next_label, level, order, offsets);
+        __bisect(g, second, parts - left_parts, labels, next_label, level, order, offsets);
+    }
+
+    // Graph partitioning of the symmetrized pattern into `parts` balanced
+    // parts with few cut edges, by recursive bisection. The order lists the
+    // parts one after another, so permute() makes each part a contiguous
+    // diagonal block with the cut edges off the blocks.
+    template<typename T>
+    partition_result recursive_bisection(const csr_matrix<T>& a, size_t parts) {
+#ifndef MATRIX_NOTHROW
+        if (parts == 0) {
+            throw std::runtime_error(__error_messages[ERR_INVALID_SIZE]);
+        }
+#endif
+        csr_matrix<char> g = __adjacency(a);
+        size_t n = g.rows();
+        std::vector<size_t> vertices(n);
+        std::vector<size_t> labels(n);
+        std::vector<size_t> level(n, std::numeric_limits<size_t>::max());
+        size_t next_label = 1;
+        std::vector<size_t> order;
+        std::vector<size_t> offsets = {0};
+        order.reserve(n);
+        std::iota(vertices.begin(), vertices.end(), size_t(0));
+        __bisect(g, vertices, parts, labels, next_label, level, order, offsets);
+        partition_result result = {permutation(std::move(order)), std::move(offsets)};
+        return result;
+    }
+
+    // Symmetric reordering P A P^T in place, for a permutation from
+    // reverse_cuthill_mckee() or recursive_bisection(). Dense vectors follow
+    // with apply_rows().
+    template<typename T>
+    void permute(csr_matrix<T>& a, const permutation& order) {
+        a.permute(order, order);
+    }
+}
+
+#endif
@@ -0,0 +1,800 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_SPARSE_H
+#define MATRIX_SPARSE_H
+
+#include "iterative.h"
+
+#include <limits>
+#include <numeric>
+
+namespace matrix {
+    // Compressed sparse row matrix: row r holds the columns
+    // indices()[offsets()[r] .. offsets()[r + 1]) with the matching values(),
+    // column indices strictly increasing within each row.
+    template<typename T>
+    class csr_matrix {
+    private:
+        size_t m_rows;
+        size_t m_columns;
+        std::vector<size_t> m_offsets;
+        std::vector<size_t> m_indices;
+        std::vector<T> m_values;
+
+    public:
+        csr_matrix() : m_rows(0), m_columns(0), m_offsets(1) {}
+
+        csr_matrix(size_t rows, size_t columns) : m_rows(rows), m_columns(columns), m_offsets(rows + 1) {}
+
+        csr_matrix(size_t rows, size_t columns, std::vector<size_t> offsets, std::vector<size_t> indices, std::vector<T> values) : m_rows(rows), m_columns(columns), m_offsets(std::move(offsets)), m_indices(std::move(indices)), m_values(std::move(values)) {
+#ifndef MATRIX_NOTHROW
+            bool valid = (m_offsets.size() == rows + 1) && (m_offsets[0] == 0) && (m_offsets[rows] == m_indices.size()) && (m_indices.size() == m_values.size());
+
+            for (size_t row = 0; valid && (row < rows); row++) {
+                valid = m_offsets[row] <= m_offsets[row + 1];
+
+                for (size_t index = m_offsets[row]; valid && (index < m_offsets[row + 1]); index++) {
+                    valid = (m_indices[index] < columns) && ((index == m_offsets[row]) || (m_indices[index - 1] < m_indices[index]));
+                }
+            }
+
+            if (!valid) {
+                throw std::runtime_error(__error_messages[ERR_SPARSE_FORMAT]);
+            }
+#endif
+        }
+
+        // Nonzero elements of a dense matrix.
+        template<size_t Rows, size_t Columns>
+        explicit csr_matrix(const matrix<T, Rows, Columns>& operand) : csr_matrix(operand.rows(), operand.columns()) {
+            for (size_t row = 0; row < m_rows; row++) {
+                for (size_t column = 0; column < m_columns; column++) {
+                    if (operand(row, column) != T()) {
+                        m_indices.push_back(column);
+                        m_values.push_back(operand(row, column));
+                    }
+                }
+
+                m_offsets[row + 1] = m_indices.size();
+            }
+        }
+
+        // Coordinate entries (rows[k], columns[k], values[k]) in any order;
+        // duplicates are summed.
+        static csr_matrix from_triplets(size_t rows, size_t columns, const std::vector<size_t>& row_indices, const std::vector<size_t>& column_indices, const std::vector<T>& values) {
+#ifndef MATRIX_NOTHROW
+            if ((row_indices.size() != column_indices.size()) || (row_indices.size() != values.size())) {
+                throw std::runtime_error(__error_messages[ERR_SPARSE_FORMAT]);
+            }
+
+            for (size_t index = 0; index < row_indices.size(); index++) {
+                if ((row_indices[index] >= rows) || (column_indices[index] >= columns)) {
+                    throw std::runtime_error(__error_messages[ERR_SPARSE_FORMAT]);
+                }
+            }
+#endif
+            // Bucket by row, then sort and merge each (short) row by column.
+            std::vector<size_t> offsets(rows + 1);
+
+            for (size_t row : row_indices) {
+                offsets[row + 1]++;
+            }
+
+            for (size_t row = 0; row < rows; row++) {
+                offsets[row + 1] = offsets[row + 1] + offsets[row];
+            }
+
+            std::vector<std::pair<size_t, T>> entries(values.size());
+            std::vector<size_t> next(offsets.begin(), offsets.end() - 1);
+
+            for (size_t index = 0; index < values.size(); index++) {
+                entries[next[row_indices[index]]++] = {column_indices[index], values[index]};
+            }
+
+            csr_matrix result(rows, columns);
+            result.m_indices.reserve(entries.size());
+            result.m_values.reserve(entries.size());
+
+            for (size_t row = 0; row < rows; row++) {
+                std::sort(entries.begin() + offsets[row], entries.begin() + offsets[row + 1], [](const std::pair<size_t, T>& x, const std::pair<size_t, T>& y) {
+                    return x.first < y.first;
+                });
+
+                for (size_t index = offsets[row]; index < offsets[row + 1]; index++) {
+                    if ((index > offsets[row]) && (entries[index].first == result.m_indices.back())) {
+                        result.m_values.back() = result.m_values.back() + entries[index].second;
+                    } else {
+                        result.m_indices.push_back(entries[index].first);
+                        result.m_values.push_back(entries[index].second);
+                    }
+                }
+
+                result.m_offsets[row + 1] = result.m_indices.size();
+            }
+
+            return result;
+        }
+
+        size_t rows() const {
+            size_t result = m_rows;
+            return result;
+        }
+
+        size_t columns() const {
+            size_t result = m_columns;
+            return result;
+        }
+
+        size_t nonzeros() const {
+            size_t result = m_indices.size();
+            return result;
+        }
+
+        const std::vector<size_t>& offsets() const {
+            return m_offsets;
+        }
+
+        const std::vector<size_t>& indices() const {
+            return m_indices;
+        }
+
+        // Values may be updated in place; the sparsity pattern is fixed.
+        std::vector<T>& values() {
+            return m_values;
+        }
+
+        const std::vector<T>& values() const {
+            return m_values;
+        }
+
+        matrix<T> to_matrix() const {
+            matrix<T> result(m_rows, m_columns);
+
+            for (size_t row = 0; row < m_rows; row++) {
+                for (size_t index = m_offsets[row]; index < m_offsets[row + 1]; index++) {
+                    result(row, m_indices[index]) = m_values[index];
+                }
+            }
+
+            return result;
+        }
+
+        // Counting sort by column; visiting rows in order keeps the column
+        // indices of the transpose sorted.
+        csr_matrix transpose() const {
+            csr_matrix result(m_columns, m_rows);
+            result.m_indices.resize(nonzeros());
+            result.m_values.resize(nonzeros());
+
+            for (size_t column : m_indices) {
+                result.m_offsets[column + 1]++;
+            }
+
+            for (size_t column = 0; column < m_columns; column++) {
+                result.m_offsets[column + 1] = result.m_offsets[column + 1] + result.m_offsets[column];
+            }
+
+            std::vector<size_t> next(result.m_offsets.begin(), result.m_offsets.end() - 1);
+
+            for (size_t row = 0; row < m_rows; row++) {
+                for (size_t index = m_offsets[row]; index < m_offsets[row + 1]; index++) {
+                    size_t target = next[m_indices[index]]++;
+                    result.m_indices[target] = row;
+                    result.m_values[target] = m_values[index];
+                }
+            }
+
+            return result;
+        }
+
+        // In place reordering to P A Q^T: new row r is old row rows[r] and
+        // new column c is old column columns[c].
+        void permute(const permutation& rows, const permutation& columns) {
+#ifndef MATRIX_NOTHROW
+            if ((rows.size() != m_rows) || (columns.size() != m_columns)) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            std::vector<size_t> column_position(m_columns);
+
+            for (size_t column = 0; column < m_columns; column++) {
+                column_position[columns[column]] = column;
+            }
+
+            std::vector<size_t> offsets(m_rows + 1);
+            std::vector<std::pair<size_t, T>> entries(nonzeros());
+
+            for (size_t row = 0; row < m_rows; row++) {
+                size_t source = rows[row];
+                offsets[row + 1] = offsets[row] + (m_offsets[source + 1] - m_offsets[source]);
+
+                for (size_t index = m_offsets[source], target = offsets[row]; index < m_offsets[source + 1]; index++, target++) {
+                    entries[target] = {column_position[m_indices[index]], m_values[index]};
+                }
+
+                std::sort(entries.begin() + offsets[row], entries.begin() + offsets[row + 1], [](const std::pair<size_t, T>& x, const std::pair<size_t, T>& y) {
+                    return x.first < y.first;
+                });
+            }
+
+            for (size_t index = 0; index < entries.size(); index++) {
+                m_indices[index] = entries[index].first;
+                m_values[index] = entries[index].second;
+            }
+
+            m_offsets = std::move(offsets);
+        }
+
+        // Sparse times dense, one output row per sparse row.
+        template<size_t Rows, size_t Columns>
+        matrix<T> operator*(const matrix<T, Rows, Columns>& operand) const {
+#ifndef MATRIX_NOTHROW
+            if (m_columns != operand.rows()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            matrix<T> result(m_rows, operand.columns());
+#ifdef _OPENMP
+            #pragma omp parallel for schedule(dynamic, 64)
+#endif
+            for (long long row = 0; row < static_cast<long long>(m_rows); row++) {
+                T* target = result.data() + row * operand.columns();
+
+                for (size_t index = m_offsets[row]; index < m_offsets[row + 1]; index++) {
+                    const T* source = operand.data() + m_indices[index] * operand.columns();
+
+                    for (size_t column = 0; column < operand.columns(); column++) {
+                        target[column] = target[column] + m_values[index] * source[column];
+                    }
+                }
+            }
+
+            return result;
+        }
+    };
+
+    // Semirings for the GraphBLAS-style products: add() folds partial
+    // results, multiply() combines a matrix entry with its operand, and
+    // zero() is the value of rows or entries that receive no terms.
+    template<typename T>
+    struct plus_times {
+        T zero() const {
+            return T();
+        }
+
+        T add(const T& x, const T& y) const {
+            T result = x + y;
+            return result;
+        }
+
+        T multiply(const T& x, const T& y) const {
+            T result = x * y;
+            return result;
+        }
+    };
+
+    // Shortest paths: (min, +) with an infinite zero.
+    template<typename T>
+    struct min_plus {
+        T zero() const {
+            return std::numeric_limits<T>::has_infinity ? std::numeric_limits<T>::infinity() : std::numeric_limits<T>::max();
+        }
+
+        T add(const T& x, const T& y) const {
+            T result = std::min(x, y);
+            return result;
+        }
+
+        T multiply(const T& x, const T& y) const {
+            T result = x + y;
+            return result;
+        }
+    };
+
+    // Reachability: nonzero values are true and results are zero or one.
+    template<typename T>
+    struct or_and {
+        T zero() const {
+            return T();
+        }
+
+        T add(const T& x, const T& y) const {
+            T result = ((x != T()) || (y != T())) ? T(1) : T();
+            return result;
+        }
+
+        T multiply(const T& x, const T& y) const {
+            T result = ((x != T()) && (y != T())) ? T(1) : T();
+            return result;
+        }
+    };
+
+    // Counts structural terms, ignoring the stored values.
+    template<typename T>
+    struct plus_pair {
+        T zero() const {
+            return T();
+        }
+
+        T add(const T& x, const T& y) const {
+            T result = x + y;
+            return result;
+        }
+
+        T multiply(const T&, const T&) const {
+            return T(1);
+        }
+    };
+
+    template<typename T, typename Semiring>
+    matrix<T> __mxv(const csr_matrix<T>& a, const matrix<T>& x, const Semiring& semiring, const std::vector<bool>* mask, bool complement) {
+#ifndef MATRIX_NOTHROW
+        if ((x.rows() != a.columns()) || (x.columns() != 1) || ((mask != nullptr) && (mask->size() != a.rows()))) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        const std::vector<size_t>& offsets = a.offsets();
+        const std::vector<size_t>& indices = a.indices();
+        const std::vector<T>& values = a.values();
+        matrix<T> result(a.rows(), 1);
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 256)
+#endif
+        for (long long row = 0; row < static_cast<long long>(a.rows()); row++) {
+            T sum = semiring.zero();
+
+            if ((mask == nullptr) || ((*mask)[row] != complement)) {
+                for (size_t index = offsets[row]; index < offsets[row + 1]; index++) {
+                    sum = semiring.add(sum, semiring.multiply(values[index], x.data()[indices[index]]));
+                }
+            }
+
+            result.data()[row] = sum;
+        }
+
+        return result;
+    }
+
+    // y = A x over a semiring.
+    template<typename T, typename Semiring = plus_times<T>>
+    matrix<T> mxv(const csr_matrix<T>& a, const matrix<T>& x, const Semiring& semiring = Semiring()) {
+        matrix<T> result = __mxv(a, x, semiring, nullptr, false);
+        return result;
+    }
+
+    // Masked y = A x: only rows whose mask entry is set (clear, when
+    // complemented) are computed; the others are the semiring zero.
+    template<typename T, typename Semiring>
+    matrix<T> mxv(const csr_matrix<T>& a, const matrix<T>& x, const Semiring& semiring, const std::vector<bool>& mask, bool complement = false) {
+        matrix<T> result = __mxv(a, x, semiring, &mask, complement);
+        return result;
+    }
+
+    // Gustavson's row-by-row product with a dense accumulator per thread.
+    // Accumulator states are stamped per row so nothing is cleared between
+    // rows: `base` marks a column the mask admits (or, complemented,
+    // excludes) and `base + 1` a column that already holds a partial sum.
+    template<typename T, typename Semiring, typename M>
+    csr_matrix<T> __mxm(const csr_matrix<T>& a, const csr_matrix<T>& b, const Semiring& semiring, const csr_matrix<M>* mask, bool complement) {
+#ifndef MATRIX_NOTHROW
+        if ((a.columns() != b.rows()) || ((mask != nullptr) && ((mask->rows() != a.rows()) || (mask->columns() != b.columns())))) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t rows = a.rows();
+        std::vector<std::vector<size_t>> row_indices(rows);
+        std::vector<std::vector<T>> row_values(rows);
+#ifdef _OPENMP
+        #pragma omp parallel
+#endif
+        {
+            std::vector<size_t> state(b.columns());
+            std::vector<T> accumulator(b.columns());
+            std::vector<size_t> touched;
+#ifdef _OPENMP
+            #pragma omp for schedule(dynamic, 64)
+#endif
+            for (long long row = 0; row < static_cast<long long>(rows); row++) {
+                size_t base = 2 * static_cast<size_t>(row) + 2;
+                bool filtered = (mask != nullptr) && !complement;
+                touched.clear();
+
+                if (mask != nullptr) {
+                    for (size_t index = mask->offsets()[row]; index < mask->offsets()[row + 1]; index++) {
+                        state[mask->indices()[index]] = base;
+                    }
+                }
+
+                for (size_t i = a.offsets()[row]; i < a.offsets()[row + 1]; i++) {
+                    size_t k = a.indices()[i];
+
+                    for (size_t j = b.offsets()[k]; j < b.offsets()[k + 1]; j++) {
+                        size_t column = b.indices()[j];
+                        T term = semiring.multiply(a.values()[i], b.values()[j]);
+
+                        if (state[column] == base + 1) {
+                            accumulator[column] = semiring.add(accumulator[column], term);
+                        } else if ((state[column] == base) == filtered) {
+                            accumulator[column] = term;
+                            state[column] = base + 1;
+                            touched.push_back(column);
+                        }
+                    }
+                }
+
+                if (filtered) {
+                    // The mask row is sorted, so walking it yields sorted output.
+                    for (size_t index = mask->offsets()[row]; index < mask->offsets()[row + 1]; index++) {
+                        size_t column = mask->indices()[index];
+
+                        if (state[column] == base + 1) {
+                            row_indices[row].push_back(column);
+                            row_values[row].push_back(accumulator[column]);
+                        }
+                    }
+                } else {
+                    std::sort(touched.begin(), touched.end());
+                    row_indices[row] = touched;
+
+                    for (size_t column : touched) {
+                        row_values[row].push_back(accumulator[column]);
+                    }
+                }
+            }
+        }
+
+        std::vector<size_t> offsets(rows + 1);
+
+        for (size_t row = 0; row < rows; row++) {
+            offsets[row + 1] = offsets[row] + row_indices[row].size();
+        }
+
+        std::vector<size_t> indices(offsets[rows]);
+        std::vector<T> values(offsets[rows]);
+
+        for (size_t row = 0; row < rows; row++) {
+            std::copy(row_indices[row].begin(), row_indices[row].end(), indices.begin() + offsets[row]);
+            std::copy(row_values[row].begin(), row_values[row].end(), values.begin() + offsets[row]);
+        }
+
+        csr_matrix<T> result(rows, b.columns(), std::move(offsets), std::move(indices), std::move(values));
+        return result;
+    }
+
+    // C = A B over a semiring, keeping every structurally reachable entry.
+    template<typename T, typename Semiring = plus_times<T>>
+    csr_matrix<T> mxm(const csr_matrix<T>& a, const csr_matrix<T>& b, const Semiring& semiring = Semiring()) {
+        csr_matrix<T> result = __mxm(a, b, semiring, static_cast<const csr_matrix<T>*>(nullptr), false);
+        return result;
+    }
+
+    // Masked C = A B: entries are only formed where the mask pattern has an
+    // entry (or, complemented, where it has none).
+    template<typename T, typename Semiring, typename M>
+    csr_matrix<T> mxm(const csr_matrix<T>& a, const csr_matrix<T>& b, const Semiring& semiring, const csr_matrix<M>& mask, bool complement = false) {
+        csr_matrix<T> result = __mxm(a, b, semiring, &mask, complement);
+        return result;
+    }
+
+    // Dot product of two contiguous rows. Eight independent partial sums
+    // break the dependency chain so the loop vectorizes without reassociation
+    // flags.
+    template<typename T>
+    T __row_dot(const T* x, const T* y, size_t length) {
+        T partial[8] = {};
+        size_t index = 0;
+
+        for (; index + 8 <= length; index += 8) {
+            for (size_t lane = 0; lane < 8; lane++) {
+                partial[lane] = partial[lane] + x[index + lane] * y[index + lane];
+            }
+        }
+
+        for (; index < length; index++) {
+            partial[0] = partial[0] + x[index] * y[index];
+        }
+
+        T result = ((partial[0] + partial[4]) + (partial[1] + partial[5])) + ((partial[2] + partial[6]) + (partial[3] + partial[7]));
+        return result;
+    }
+
+    // Sampled dense-dense product: (A B^T)(i, j) for exactly the entries
+    // (i, j) of the pattern, each one dot product of row i of A with row j
+    // of B, returned on the pattern's structure. Scale by the pattern's
+    // values afterwards for the masked-product form.
+    template<typename T, size_t RowsA, size_t ColumnsA, size_t RowsB, size_t ColumnsB, typename M>
+    csr_matrix<T> sddmm(const matrix<T, RowsA, ColumnsA>& a, const matrix<T, RowsB, ColumnsB>& b, const csr_matrix<M>& pattern) {
+#ifndef MATRIX_NOTHROW
+        if ((a.columns() != b.columns()) || (pattern.rows() != a.rows()) || (pattern.columns() != b.rows())) {
+            throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+        }
+#endif
+        size_t length = a.columns();
+        std::vector<T> values(pattern.nonzeros());
+#ifdef _OPENMP
+        #pragma omp parallel for schedule(dynamic, 64)
+#endif
+        for (long long row = 0; row < static_cast<long long>(pattern.rows()); row++) {
+            const T* x = a.data() + row * length;
+
+            for (size_t index = pattern.offsets()[row]; index < pattern.offsets()[row + 1]; index++) {
+                values[index] = __row_dot(x, b.data() + pattern.indices()[index] * length, length);
+            }
+        }
+
+        csr_matrix<T> result(pattern.rows(), pattern.columns(), pattern.offsets(), pattern.indices(), std::move(values));
+        return result;
+    }
+
+    struct bfs_result {
+        std::vector<size_t> levels;
+        std::vector<size_t> parents;
+    };
+
+    // Direction-optimizing breadth-first search from `source` along the
+    // edges i -> j of the entries a(i, j). Top-down steps push the frontier
+    // along its out-edges; once those outnumber a fourteenth of the edges
+    // left unexplored, bottom-up steps let every unvisited vertex pull from
+    // its in-edges instead, until the frontier drops below n / 24 vertices
+    // (Beamer et al.). Unreached vertices keep level and parent SIZE_MAX.
+    template<typename T>
+    bfs_result breadth_first_search(const csr_matrix<T>& a, size_t source) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+
+        if (source >= a.rows()) {
+            throw std::runtime_error(__error_messages[ERR_ROW_RANGE]);
+        }
+#endif
+        const size_t none = std::numeric_limits<size_t>::max();
+        size_t n = a.rows();
+        const std::vector<size_t>& out = a.offsets();
+        csr_matrix<T> incoming = a.transpose();
+        bfs_result result = {std::vector<size_t>(n, none), std::vector<size_t>(n, none)};
+        std::vector<size_t> frontier = {source};
+        std::vector<char> in_frontier(n);
+        size_t unexplored = a.nonzeros() - (out[source + 1] - out[source]);
+        bool bottom_up = false;
+        result.levels[source] = 0;
+        result.parents[source] = source;
+
+        for (size_t depth = 0; !frontier.empty(); depth++) {
+            size_t frontier_edges = 0;
+
+            for (size_t vertex : frontier) {
+                frontier_edges = frontier_edges + (out[vertex + 1] - out[vertex]);
+            }
+
+            if (!bottom_up && (frontier_edges > unexplored / 14)) {
+                bottom_up = true;
+            } else if (bottom_up && (frontier.size() < n / 24)) {
+                bottom_up = false;
+            }
+
+            std::vector<size_t> next;
+
+            if (bottom_up) {
+                // Each vertex writes only its own entries.
+                std::vector<char> found(n);
+
+                for (size_t vertex : frontier) {
+                    in_frontier[vertex] = 1;
+                }
+#ifdef _OPENMP
+                #pragma omp parallel for schedule(dynamic, 256)
+#endif
+                for (long long vertex = 0; vertex < static_cast<long long>(n); vertex++) {
+                    if (result.levels[vertex] != none) {
+                        continue;
+                    }
+
+                    for (size_t index = incoming.offsets()[vertex]; index < incoming.offsets()[vertex + 1]; index++) {
+                        size_t parent = incoming.indices()[index];
+
+                        if (in_frontier[parent]) {
+                            result.levels[vertex] = depth + 1;
+                            result.parents[vertex] = parent;
+                            found[vertex] = 1;
+                            break;
+                        }
+                    }
+                }
+
+                for (size_t vertex : frontier) {
+                    in_frontier[vertex] = 0;
+                }
+
+                for (size_t vertex = 0; vertex < n; vertex++) {
+                    if (found[vertex]) {
+                        next.push_back(vertex);
+                    }
+                }
+            } else {
+                // Levels are only read while the frontier is expanded; the
+                // candidate edges are claimed afterwards.
+                std::vector<std::pair<size_t, size_t>> candidates;
+#ifdef _OPENMP
+                #pragma omp parallel
+#endif
+                {
+                    std::vector<std::pair<size_t, size_t>> local;
+#ifdef _OPENMP
+                    #pragma omp for schedule(dynamic, 64) nowait
+#endif
+                    for (long long k = 0; k < static_cast<long long>(frontier.size()); k++) {
+                        size_t parent = frontier[k];
+
+                        for (size_t index = out[parent]; index < out[parent + 1]; index++) {
+                            if (result.levels[a.indices()[index]] == none) {
+                                local.emplace_back(a.indices()[index], parent);
+                            }
+                        }
+                    }
+#ifdef _OPENMP
+                    #pragma omp critical
+#endif
+                    candidates.insert(candidates.end(), local.begin(), local.end());
+                }
+
+                for (const std::pair<size_t, size_t>& edge : candidates) {
+                    if (result.levels[edge.first] == none) {
+                        result.levels[edge.first] = depth + 1;
+                        result.parents[edge.first] = edge.second;
+                        next.push_back(edge.first);
+                    }
+                }
+            }
+
+            for (size_t vertex : next) {
+                unexplored = unexplored - (out[vertex + 1] - out[vertex]);
+            }
+
+            frontier = std::move(next);
+        }
+
+        return result;
+    }
+
+    // PageRank by power iteration over the edges i -> j of the entries
+    // a(i, j): r' = (1 - d) / n + d (P^T r + (dangling mass) / n) with P the
+    // row-normalized adjacency, so each step is one mxv with P^T. Converges
+    // when the change in the L1 norm drops below options.tolerance; with
+    // options.state set, the ranks are checkpointed like the other
+    // iterative solvers.
+    template<typename T>
+    iterative_result<double> pagerank(const csr_matrix<T>& a, double damping = 0.85, const iterative_options& options = iterative_options()) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        size_t n = a.rows();
+        std::vector<size_t> degree(n);
+
+        for (size_t row = 0; row < n; row++) {
+            degree[row] = a.offsets()[row + 1] - a.offsets()[row];
+        }
+
+        std::vector<double> weights(a.nonzeros());
+
+        for (size_t row = 0; row < n; row++) {
+            for (size_t index = a.offsets()[row]; index < a.offsets()[row + 1]; index++) {
+                weights[index] = 1.0 / double(degree[row]);
+            }
+        }
+
+        csr_matrix<double> transition = csr_matrix<double>(n, n, a.offsets(), a.indices(), std::move(weights)).transpose();
+        matrix<double> rank(n, 1);
+        rank.transform([&](size_t, size_t, double& value) { value = 1.0 / double(n); });
+        size_t iteration = 0;
+        double residual = 1.0;
+        bool converged = false;
+
+        if (options.state != nullptr) {
+            options.state->restore([&](std::istream& stream) {
+                iteration = __read_index(stream);
+                rank = read_binary<double>(stream);
+#ifndef MATRIX_NOTHROW
+                if ((rank.rows() != n) || (rank.columns() != 1)) {
+                    throw std::runtime_error(__error_messages[ERR_CHECKPOINT]);
+                }
+#endif
+            });
+        }
+
+        while (iteration < options.max_iterations) {
+            double dangling = 0;
+
+            for (size_t vertex = 0; vertex < n; vertex++) {
+                if (degree[vertex] == 0) {
+                    dangling = dangling + rank(vertex, 0);
+                }
+            }
+
+            matrix<double> next = mxv(transition, rank);
+            double teleport = (1.0 - damping + damping * dangling) / double(n);
+            residual = 0;
+
+            for (size_t vertex = 0; vertex < n; vertex++) {
+                next(vertex, 0) = damping * next(vertex, 0) + teleport;
+                residual = residual + std::abs(next(vertex, 0) - rank(vertex, 0));
+            }
+
+            rank = std::move(next);
+            iteration++;
+
+            if (residual <= options.tolerance) {
+                converged = true;
+                break;
+            }
+
+            if ((options.state != nullptr) && options.state->due(iteration)) {
+                options.state->save([&](std::ostream& stream) {
+                    __write_index(stream, iteration);
+                    write_binary(stream, rank);
+                });
+            }
+        }
+
+        if (options.state != nullptr) {
+            options.state->clear();
+        }
+
+        iterative_result<double> result = {std::move(rank), iteration, residual, converged};
+        return result;
+    }
+
+    // Triangles of an undirected graph given by a symmetric pattern, with
+    // the diagonal ignored. With L the strict lower triangle, the masked
+    // product (L L) .* L holds, for every edge, the number of wedges it
+    // closes, and each triangle is counted exactly once.
+    template<typename T>
+    size_t triangle_count(const csr_matrix<T>& a) {
+#ifndef MATRIX_NOTHROW
+        if (a.rows() != a.columns()) {
+            throw std::runtime_error(__error_messages[ERR_NOT_SQUARE]);
+        }
+#endif
+        std::vector<size_t> offsets(a.rows() + 1);
+        std::vector<size_t> indices;
+
+        for (size_t row = 0; row < a.rows(); row++) {
+            for (size_t index = a.offsets()[row]; (index < a.offsets()[row + 1]) && (a.indices()[index] < row); index++) {
+                indices.push_back(a.indices()[index]);
+            }
+
+            offsets[row + 1] = indices.size();
+        }
+
+        std::vector<size_t> ones(indices.size(), 1);
+        csr_matrix<size_t> lower(a.rows(), a.columns(), std::move(offsets), std::move(indices), std::move(ones));
+        csr_matrix<size_t> wedges = mxm(lower, lower, plus_pair<size_t>(), lower);
+        size_t result = std::accumulate(wedges.values().begin(), wedges.values().end(), size_t(0));
+        return result;
+    }
+}
+
+#endif
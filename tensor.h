@@ -0,0 +1,638 @@
+/*
+Copyright (c) 2023 William M.H.
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+
+#ifndef MATRIX_TENSOR_H
+#define MATRIX_TENSOR_H
+
+#include "matrix.h"
+
+#include <cctype>
+#include <cstdint>
+#include <limits>
+
+namespace matrix {
+    // Dense row-major N-dimensional array. Storage is a contiguous vector as
+    // for dynamic matrices, and any split of the axes into leading and
+    // trailing groups can be viewed as a matrix without copying.
+    template<typename T>
+    class tensor {
+    private:
+        std::vector<size_t> m_shape;
+        std::vector<T> m_data;
+
+        size_t __offset(std::initializer_list<size_t> index) const {
+#ifndef MATRIX_NOTHROW
+            if (index.size() != m_shape.size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            size_t result = 0;
+            size_t axis = 0;
+
+            for (size_t value : index) {
+#ifndef MATRIX_NOTHROW
+                if (value >= m_shape[axis]) {
+                    throw std::runtime_error(__error_messages[ERR_INDEX_RANGE]);
+                }
+#endif
+                result = result * m_shape[axis] + value;
+                axis++;
+            }
+
+            return result;
+        }
+
+    public:
+        tensor() : m_data(1) {}
+
+        explicit tensor(std::vector<size_t> shape, T fill = T()) : m_shape(std::move(shape)) {
+            size_t count = 1;
+
+            for (size_t extent : m_shape) {
+                count = count * extent;
+            }
+
+            m_data.assign(count, fill);
+        }
+
+        template<size_t Rows, size_t Columns>
+        explicit tensor(const matrix<T, Rows, Columns>& operand) : tensor({operand.rows(), operand.columns()}) {
+            for (size_t row = 0; row < operand.rows(); row++) {
+                for (size_t column = 0; column < operand.columns(); column++) {
+                    m_data[row * operand.columns() + column] = operand(row, column);
+                }
+            }
+        }
+
+        size_t rank() const {
+            size_t result = m_shape.size();
+            return result;
+        }
+
+        const std::vector<size_t>& shape() const {
+            const std::vector<size_t>& result = m_shape;
+            return result;
+        }
+
+        size_t extent(size_t axis) const {
+            size_t result = m_shape.at(axis);
+            return result;
+        }
+
+        size_t size() const {
+            size_t result = m_data.size();
+            return result;
+        }
+
+        T* data() {
+            T* result = m_data.data();
+            return result;
+        }
+
+        const T* data() const {
+            const T* result = m_data.data();
+            return result;
+        }
+
+        template<typename... Index>
+        T& operator()(Index... index) {
+            T& result = m_data[__offset({static_cast<size_t>(index)...})];
+            return result;
+        }
+
+        template<typename... Index>
+        const T& operator()(Index... index) const {
+            const T& result = m_data[__offset({static_cast<size_t>(index)...})];
+            return result;
+        }
+
+        template<typename F>
+        void transform(F&& f) {
+            for (T& value : m_data) {
+                f(value);
+            }
+        }
+
+        // The first `split` axes become rows and the rest columns.
+        matrix_view<T> matricize(size_t split) {
+            size_t rows = 1;
+
+            for (size_t axis = 0; axis < std::min(split, m_shape.size()); axis++) {
+                rows = rows * m_shape[axis];
+            }
+
+            size_t columns = (rows > 0) ? m_data.size() / rows : 0;
+            matrix_view<T> result(m_data.data(), rows, columns, columns, 1);
+            return result;
+        }
+
+        matrix_view<const T> matricize(size_t split) const {
+            matrix_view<const T> result = const_cast<tensor*>(this)->matricize(split);
+            return result;
+        }
+
+        tensor reshape(std::vector<size_t> shape) const {
+            tensor result(std::move(shape));
+#ifndef MATRIX_NOTHROW
+            if (result.size() != size()) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+#endif
+            result.m_data = m_data;
+            return result;
+        }
+
+        // Axis `index` of the result is axis axes[index] of this tensor.
+        tensor permute(const std::vector<size_t>& axes) const {
+            size_t n = m_shape.size();
+            std::vector<size_t> shape(n);
+            std::vector<size_t> strides(n);
+            std::vector<size_t> source(n, 1);
+#ifndef MATRIX_NOTHROW
+            std::vector<bool> seen(n);
+
+            if (axes.size() != n) {
+                throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+            }
+
+            for (size_t axis : axes) {
+                if ((axis >= n) || seen[axis]) {
+                    throw std::runtime_error(__error_messages[ERR_INDEX_RANGE]);
+                }
+
+                seen[axis] = true;
+            }
+#endif
+            for (size_t axis = n; axis-- > 1;) {
+                source[axis - 1] = source[axis] * m_shape[axis];
+            }
+
+            for (size_t axis = 0; axis < n; axis++) {
+                shape[axis] = m_shape[axes[axis]];
+                strides[axis] = source[axes[axis]];
+            }
+
+            tensor result(shape);
+
+            if ((n == 0) || (result.size() == 0)) {
+                result.m_data = m_data;
+                return result;
+            }
+
+            // Odometer over the result, moving the source offset along.
+            std::vector<size_t> index(n);
+            size_t offset = 0;
+            size_t inner = (n > 0) ? shape[n - 1] : 1;
+            size_t step = (n > 0) ? strides[n - 1] : 0;
+
+            for (size_t position = 0; position < result.size(); position += inner) {
+                for (size_t k = 0; k < inner; k++) {
+                    result.m_data[position + k] = m_data[offset + k * step];
+                }
+
+                for (size_t axis = n - 1; axis-- > 0;) {
+                    index[axis]++;
+                    offset = offset + strides[axis];
+
+                    if (index[axis] < shape[axis]) {
+                        break;
+                    }
+
+                    offset = offset - index[axis] * strides[axis];
+                    index[axis] = 0;
+                }
+            }
+
+            return result;
+        }
+    };
+
+    template<typename T>
+    struct __einsum_term {
+        std::string labels;
+        tensor<T> value;
+    };
+
+    // Keeps the labels of `term` that occur in `keep`, in order of first
+    // appearance, summing over the others and taking diagonals of repeated
+    // labels.
+    template<typename T>
+    __einsum_term<T> __einsum_reduce(const __einsum_term<T>& term, const std::string& keep) {
+        std::string unique;
+        std::string kept;
+
+        for (char label : term.labels) {
+            if (unique.find(label) == std::string::npos) {
+                unique.push_back(label);
+
+                if (keep.find(label) != std::string::npos) {
+                    kept.push_back(label);
+                }
+            }
+        }
+
+        if ((unique.size() == term.labels.size()) && (kept.size() == unique.size())) {
+            return term;
+        }
+
+        std::vector<size_t> extents(unique.size());
+        std::vector<size_t> source(unique.size());
+        std::vector<size_t> target(unique.size());
+        std::vector<size_t> shape;
+        size_t stride = 1;
+
+        for (size_t axis = term.labels.size(); axis-- > 0;) {
+            size_t position = unique.find(term.labels[axis]);
+            extents[position] = term.value.extent(axis);
+            source[position] = source[position] + stride;
+            stride = stride * term.value.extent(axis);
+        }
+
+        for (char label : kept) {
+            shape.push_back(extents[unique.find(label)]);
+        }
+
+        stride = 1;
+
+        for (size_t axis = kept.size(); axis-- > 0;) {
+            target[unique.find(kept[axis])] = stride;
+            stride = stride * shape[axis];
+        }
+
+        __einsum_term<T> result = {kept, tensor<T>(shape)};
+        size_t total = 1;
+
+        for (size_t extent : extents) {
+            total = total * extent;
+        }
+
+        std::vector<size_t> index(unique.size());
+        size_t from = 0;
+        size_t to = 0;
+
+        for (size_t position = 0; position < total; position++) {
+            result.value.data()[to] = result.value.data()[to] + term.value.data()[from];
+
+            for (size_t axis = unique.size(); axis-- > 0;) {
+                index[axis]++;
+                from = from + source[axis];
+                to = to + target[axis];
+
+                if (index[axis] < extents[axis]) {
+                    break;
+                }
+
+                from = from - index[axis] * source[axis];
+                to = to - index[axis] * target[axis];
+                index[axis] = 0;
+            }
+        }
+
+        return result;
+    }
+
+    // Pairwise contraction by transpose-transpose-GEMM-transpose: both
+    // operands are permuted to [batch, free, contracted] and
+    // [batch, contracted, free], each batch is one GEMM, and the result
+    // comes out as [batch, free a, free b].
+    template<typename T>
+    __einsum_term<T> __einsum_contract(const __einsum_term<T>& left, const __einsum_term<T>& right, const std::string& keep) {
+        auto in = [](const std::string& labels, char label) { return labels.find(label) != std::string::npos; };
+        __einsum_term<T> a = __einsum_reduce(left, right.labels + keep);
+        __einsum_term<T> b = __einsum_reduce(right, a.labels + keep);
+        std::string batch;
+        std::string free_a;
+        std::string free_b;
+        std::string contracted;
+
+        for (char label : a.labels) {
+            if (!in(b.labels, label)) {
+                free_a.push_back(label);
+            } else if (in(keep, label)) {
+                batch.push_back(label);
+            } else {
+                contracted.push_back(label);
+            }
+        }
+
+        for (char label : b.labels) {
+            if (!in(a.labels, label)) {
+                free_b.push_back(label);
+            }
+        }
+
+        auto arrange = [&](const __einsum_term<T>& term, const std::string& order) {
+            std::vector<size_t> axes;
+            bool identity = true;
+
+            for (char label : order) {
+                axes.push_back(term.labels.find(label));
+                identity = identity && (axes.back() == axes.size() - 1);
+            }
+
+            tensor<T> result = identity ? term.value : term.value.permute(axes);
+            return result;
+        };
+
+        auto extent = [&](const std::string& labels) {
+            size_t result = 1;
+
+            for (char label : labels) {
+                result = result * (in(a.labels, label) ? a.value.extent(a.labels.find(label)) : b.value.extent(b.labels.find(label)));
+            }
+
+            return result;
+        };
+
+        tensor<T> x = arrange(a, batch + free_a + contracted);
+        tensor<T> y = arrange(b, batch + contracted + free_b);
+        size_t batches = extent(batch);
+        size_t m = extent(free_a);
+        size_t k = extent(contracted);
+        size_t n = extent(free_b);
+        std::vector<size_t> shape;
+
+        for (char label : batch + free_a + free_b) {
+            shape.push_back(in(a.labels, label) ? a.value.extent(a.labels.find(label)) : b.value.extent(b.labels.find(label)));
+        }
+
+        __einsum_term<T> result = {batch + free_a + free_b, tensor<T>(shape)};
+
+        if ((m > 0) && (n > 0) && (k > 0)) {
+            for (size_t index = 0; index < batches; index++) {
+                matrix_view<const T> p(x.data() + index * m * k, m, k, k, 1);
+                matrix_view<const T> q(y.data() + index * k * n, k, n, n, 1);
+                matrix_view<T> c(result.value.data() + index * m * n, m, n, n, 1);
+                gemm(T(1), p, q, T(), c);
+            }
+        }
+
+        return result;
+    }
+
+    // Contraction tree for einsum. Up to twelve operands the order with the
+    // fewest multiply-adds is found by dynamic programming over subsets;
+    // beyond that the cheapest pair is contracted greedily.
+    class __einsum_plan {
+    private:
+        std::vector<std::string> m_labels;
+        std::string m_output;
+        std::vector<size_t> m_extents;
+        std::vector<std::pair<uint64_t, uint64_t>> m_splits;
+        std::vector<std::pair<uint64_t, std::pair<uint64_t, uint64_t>>> m_greedy;
+
+    public:
+        __einsum_plan(std::vector<std::string> labels, std::string output, std::vector<size_t> extents) : m_labels(std::move(labels)), m_output(std::move(output)), m_extents(std::move(extents)) {
+            size_t n = m_labels.size();
+
+            if (n <= 12) {
+                uint64_t full = (uint64_t(1) << n) - 1;
+                std::vector<double> cost(full + 1, std::numeric_limits<double>::infinity());
+                m_splits.assign(full + 1, {0, 0});
+
+                for (size_t index = 0; index < n; index++) {
+                    cost[uint64_t(1) << index] = 0;
+                }
+
+                for (uint64_t set = 1; set <= full; set++) {
+                    if ((set & (set - 1)) == 0) {
+                        continue;
+                    }
+
+                    for (uint64_t part = (set - 1) & set; part > 0; part = (part - 1) & set) {
+                        uint64_t other = set ^ part;
+
+                        if (part < other) {
+                            continue;
+                        }
+
+                        double candidate = cost[part] + cost[other] + flops(part, other);
+
+                        if (candidate < cost[set]) {
+                            cost[set] = candidate;
+                            m_splits[set] = {part, other};
+                        }
+                    }
+                }
+            } else {
+                std::vector<uint64_t> remaining;
+
+                for (size_t index = 0; index < n; index++) {
+                    remaining.push_back(uint64_t(1) << index);
+                }
+
+                while (remaining.size() > 1) {
+                    size_t best_i = 0;
+                    size_t best_j = 1;
+                    double best = std::numeric_limits<double>::infinity();
+
+                    for (size_t i = 0; i < remaining.size(); i++) {
+                        for (size_t j = i + 1; j < remaining.size(); j++) {
+                            double candidate = flops(remaining[i], remaining[j]);
+
+                            if (candidate < best) {
+                                best = candidate;
+                                best_i = i;
+                                best_j = j;
+                            }
+                        }
+                    }
+
+                    uint64_t set = remaining[best_i] | remaining[best_j];
+                    m_greedy.push_back({set, {remaining[best_i], remaining[best_j]}});
+                    remaining.erase(remaining.begin() + best_j);
+                    remaining[best_i] = set;
+                }
+            }
+        }
+
+        // Labels the intermediate for a set of operands must keep: those
+        // still needed by operands outside the set or by the output.
+        std::string labels(uint64_t set) const {
+            std::string result;
+
+            for (size_t index = 0; index < m_labels.size(); index++) {
+                if ((set >> index) & 1) {
+                    for (char label : m_labels[index]) {
+                        if (result.find(label) != std::string::npos) {
+                            continue;
+                        }
+
+                        bool needed = m_output.find(label) != std::string::npos;
+
+                        for (size_t other = 0; (other < m_labels.size()) && !needed; other++) {
+                            needed = !((set >> other) & 1) && (m_labels[other].find(label) != std::string::npos);
+                        }
+
+                        if (needed) {
+                            result.push_back(label);
+                        }
+                    }
+                }
+            }
+
+            return result;
+        }
+
+        double flops(uint64_t left, uint64_t right) const {
+            std::string all = labels(left) + labels(right);
+            std::string seen;
+            double result = 1;
+
+            for (char label : all) {
+                if (seen.find(label) == std::string::npos) {
+                    seen.push_back(label);
+                    result = result * double(m_extents[static_cast<unsigned char>(label)]);
+                }
+            }
+
+            return result;
+        }
+
+        std::pair<uint64_t, uint64_t> split(uint64_t set) const {
+            if (!m_splits.empty()) {
+                std::pair<uint64_t, uint64_t> result = m_splits[set];
+                return result;
+            }
+
+            for (const auto& step : m_greedy) {
+                if (step.first == set) {
+                    std::pair<uint64_t, uint64_t> result = step.second;
+                    return result;
+                }
+            }
+
+            return {0, 0};
+        }
+    };
+
+    template<typename T>
+    __einsum_term<T> __einsum_evaluate(const __einsum_plan& plan, std::vector<__einsum_term<T>>& terms, uint64_t set) {
+        if ((set & (set - 1)) == 0) {
+            size_t index = 0;
+
+            while (((set >> index) & 1) == 0) {
+                index++;
+            }
+
+            __einsum_term<T> result = __einsum_reduce(terms[index], plan.labels(set));
+            return result;
+        }
+
+        std::pair<uint64_t, uint64_t> parts = plan.split(set);
+        __einsum_term<T> left = __einsum_evaluate(plan, terms, parts.first);
+        __einsum_term<T> right = __einsum_evaluate(plan, terms, parts.second);
+        __einsum_term<T> result = __einsum_contract(left, right, plan.labels(set));
+        return result;
+    }
+
+    // Einstein summation in numpy notation, e.g. einsum("bij,bjk->bik", a, b)
+    // or einsum("ij,jk,kl", a, b, c). Without "->" the output is the labels
+    // used exactly once, in alphabetical order. Repeated labels within an
+    // operand take its diagonal.
+    template<typename T, typename... Tensors>
+    tensor<T> einsum(const std::string& subscripts, const tensor<T>& first, const Tensors&... rest) {
+        std::vector<const tensor<T>*> operands = {&first, &rest...};
+        std::vector<std::string> labels(1);
+        std::string output;
+        size_t arrow = subscripts.find("->");
+        std::string inputs = subscripts.substr(0, arrow);
+        std::vector<size_t> extents(128, 0);
+        std::vector<size_t> counts(128, 0);
+
+        for (char c : inputs) {
+            if (c == ',') {
+                labels.emplace_back();
+            } else if (c != ' ') {
+                labels.back().push_back(c);
+            }
+        }
+#ifndef MATRIX_NOTHROW
+        if ((labels.size() != operands.size()) || (operands.size() > 64)) {
+            throw std::runtime_error(__error_messages[ERR_SUBSCRIPTS]);
+        }
+#endif
+        for (size_t index = 0; index < labels.size(); index++) {
+#ifndef MATRIX_NOTHROW
+            if (labels[index].size() != operands[index]->rank()) {
+                throw std::runtime_error(__error_messages[ERR_SUBSCRIPTS]);
+            }
+#endif
+            for (size_t axis = 0; axis < labels[index].size(); axis++) {
+                unsigned char label = static_cast<unsigned char>(labels[index][axis]);
+#ifndef MATRIX_NOTHROW
+                if (!std::isalpha(label)) {
+                    throw std::runtime_error(__error_messages[ERR_SUBSCRIPTS]);
+                }
+
+                if ((counts[label] > 0) && (extents[label] != operands[index]->extent(axis))) {
+                    throw std::runtime_error(__error_messages[ERR_INCOMPATIBLE]);
+                }
+#endif
+                extents[label] = operands[index]->extent(axis);
+                counts[label]++;
+            }
+        }
+
+        if (arrow != std::string::npos) {
+            for (char c : subscripts.substr(arrow + 2)) {
+                if (c != ' ') {
+                    output.push_back(c);
+                }
+            }
+        } else {
+            for (size_t label = 0; label < counts.size(); label++) {
+                if (counts[label] == 1) {
+                    output.push_back(static_cast<char>(label));
+                }
+            }
+        }
+#ifndef MATRIX_NOTHROW
+        for (size_t index = 0; index < output.size(); index++) {
+            if ((counts[static_cast<unsigned char>(output[index])] == 0) || (output.find(output[index]) != index)) {
+                throw std::runtime_error(__error_messages[ERR_SUBSCRIPTS]);
+            }
+        }
+#endif
+        std::vector<__einsum_term<T>> terms;
+
+        for (size_t index = 0; index < operands.size(); index++) {
+            terms.push_back({labels[index], *operands[index]});
+        }
+
+        __einsum_plan plan(labels, output, extents);
+        uint64_t full = (operands.size() == 64) ? ~uint64_t(0) : (uint64_t(1) << operands.size()) - 1;
+        __einsum_term<T> term = __einsum_evaluate(plan, terms, full);
+        term = __einsum_reduce(term, output);
+        std::vector<size_t> axes;
+
+        for (char label : output) {
+            axes.push_back(term.labels.find(label));
+        }
+
+        tensor<T> result = term.value.permute(axes);
+        return result;
+    }
+}
+
+#endif